@@ -0,0 +1,104 @@
+#include "BatchRenderer.h"
+#include "wx/imagpng.h"
+#include <chrono>
+#include <format>
+#include <future>
+
+namespace {
+chartview::batchresult
+MakeResult(size_t jobs, std::vector<std::string> errors,
+           std::chrono::steady_clock::duration elapsed) {
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  const size_t images = jobs - errors.size();
+
+  return {.images = images,
+          .errors = std::move(errors),
+          .seconds = seconds,
+          .imagesPerSecond =
+              seconds > 0 ? static_cast<double>(images) / seconds : 0.0};
+}
+} // namespace
+
+BatchRenderer::BatchRenderer(unsigned threadCount) : m_pool(threadCount) {
+  if (wxImage::FindHandler(wxBITMAP_TYPE_PNG) == nullptr) {
+    wxImage::AddHandler(new wxPNGHandler);
+  }
+}
+
+chartview::batchresult
+BatchRenderer::Render(const std::vector<chartview::thumbnailjob> &jobs) {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::future<tl::expected<void, std::string>>> pending;
+  pending.reserve(jobs.size());
+  for (const auto &job : jobs) {
+    pending.push_back(m_pool.Submit([&job]() { return RenderJob(job); }));
+  }
+
+  std::vector<std::string> errors;
+  for (auto &result : pending) {
+    auto res = result.get();
+    if (!res) {
+      errors.push_back(std::move(res.error()));
+    }
+  }
+
+  return MakeResult(jobs.size(), std::move(errors),
+                    std::chrono::steady_clock::now() - start);
+}
+
+chartview::batchresult
+BatchRenderer::RenderSerial(const std::vector<chartview::thumbnailjob> &jobs) {
+  if (wxImage::FindHandler(wxBITMAP_TYPE_PNG) == nullptr) {
+    wxImage::AddHandler(new wxPNGHandler);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::string> errors;
+  for (const auto &job : jobs) {
+    auto res = RenderJob(job);
+    if (!res) {
+      errors.push_back(std::move(res.error()));
+    }
+  }
+
+  return MakeResult(jobs.size(), std::move(errors),
+                    std::chrono::steady_clock::now() - start);
+}
+
+unsigned BatchRenderer::GetThreadCount() const {
+  return m_pool.GetThreadCount();
+}
+
+tl::expected<void, std::string>
+BatchRenderer::RenderJob(const chartview::thumbnailjob &job) {
+  if (job.width <= 0 || job.height <= 0) {
+    return tl::make_unexpected(
+        std::format("batch error: invalid image size {}x{} for {}", job.width,
+                    job.height, job.path.ToStdString()));
+  }
+
+  ChartRenderer renderer;
+  auto res = renderer.SetPlotData(job.xs, job.ys);
+  if (!res) {
+    return tl::make_unexpected(std::format(
+        "batch error: {} for {}", res.error(), job.path.ToStdString()));
+  }
+
+  wxImage image(job.width, job.height, false);
+  if (!image.IsOk()) {
+    return tl::make_unexpected(std::format(
+        "batch error: failed to create {}x{} image for {}", job.width,
+        job.height, job.path.ToStdString()));
+  }
+
+  renderer.RasterizePlot(image);
+
+  if (!image.SaveFile(job.path, wxBITMAP_TYPE_PNG)) {
+    return tl::make_unexpected(
+        std::format("batch error: failed to save {}", job.path.ToStdString()));
+  }
+
+  return {};
+}
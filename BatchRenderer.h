@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ChartRenderer.h"
+#include "ThreadPool.h"
+#include "expected.hpp"
+
+#include <string>
+#include <vector>
+
+namespace chartview {
+struct thumbnailjob {
+  std::vector<double> xs;
+  std::vector<double> ys;
+  int width;
+  int height;
+  wxString path;
+};
+
+struct batchresult {
+  size_t images;
+  std::vector<std::string> errors;
+  double seconds;
+  double imagesPerSecond;
+};
+} // namespace chartview
+
+// Renders many series to PNG files. Each job is decimated and rasterized with
+// ChartRenderer::RasterizePlot on a pool thread, so no job touches wx GDI
+// objects. Must be constructed on the main thread, which registers the PNG
+// handler before any worker uses it.
+class BatchRenderer {
+public:
+  explicit BatchRenderer(
+      unsigned threadCount = std::thread::hardware_concurrency());
+
+  // Render all jobs concurrently on the pool
+  chartview::batchresult
+  Render(const std::vector<chartview::thumbnailjob> &jobs);
+  // Render all jobs one after another on the calling thread, for comparison
+  static chartview::batchresult
+  RenderSerial(const std::vector<chartview::thumbnailjob> &jobs);
+
+  [[nodiscard]] unsigned GetThreadCount() const;
+
+private:
+  ThreadPool m_pool;
+
+  static tl::expected<void, std::string>
+  RenderJob(const chartview::thumbnailjob &job);
+};
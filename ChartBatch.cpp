@@ -0,0 +1,74 @@
+#include <wx/wx.h>
+
+#include "BatchRenderer.h"
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <string>
+
+// Renders a set of sine thumbnails serially and on the thread pool and
+// reports the throughput of both.
+//
+// usage: ChartBatch [images] [points] [outdir]
+int main(int argc, char **argv) {
+  wxInitializer initializer(argc, argv);
+  if (!initializer.IsOk()) {
+    std::cerr << "failed to initialize wxWidgets\n";
+    return 1;
+  }
+
+  size_t imageCount = 200;
+  size_t pointCount = 100'000;
+  std::string outDir = ".";
+  try {
+    if (argc > 1) {
+      imageCount = std::stoul(argv[1]);
+    }
+    if (argc > 2) {
+      pointCount = std::stoul(argv[2]);
+    }
+    if (argc > 3) {
+      outDir = argv[3];
+    }
+  } catch (const std::exception &e) {
+    std::cerr << std::format("invalid argument: {}\n", e.what());
+    return 1;
+  }
+
+  std::vector<chartview::thumbnailjob> jobs(imageCount);
+  for (size_t n = 0; n < jobs.size(); ++n) {
+    auto &job = jobs[n];
+    job.xs.resize(pointCount);
+    job.ys.resize(pointCount);
+    for (size_t i = 0; i < pointCount; i++) {
+      job.xs[i] = 0.01 * static_cast<double>(i);
+      job.ys[i] = (5 * std::sin(job.xs[i] + static_cast<double>(n))) + 2.1;
+    }
+    job.width = 320;
+    job.height = 200;
+    job.path = wxString::FromUTF8(std::format("{}/thumb_{}.png", outDir, n));
+  }
+
+  BatchRenderer renderer;
+
+  const auto serial = BatchRenderer::RenderSerial(jobs);
+  const auto parallel = renderer.Render(jobs);
+
+  for (const auto &error : parallel.errors) {
+    std::cerr << error << '\n';
+  }
+
+  std::cout << std::format("serial:   {} images in {:.3f} s, {:.1f} images/s\n",
+                           serial.images, serial.seconds,
+                           serial.imagesPerSecond);
+  std::cout << std::format(
+      "parallel: {} images in {:.3f} s, {:.1f} images/s ({} threads)\n",
+      parallel.images, parallel.seconds, parallel.imagesPerSecond,
+      renderer.GetThreadCount());
+  if (serial.imagesPerSecond > 0) {
+    std::cout << std::format("speedup:  {:.2f}x\n", parallel.imagesPerSecond /
+                                                        serial.imagesPerSecond);
+  }
+
+  return parallel.errors.empty() ? 0 : 1;
+}
@@ -0,0 +1,1390 @@
+#include "ChartRenderer.h"
+#include "Decimation.h"
+#include "DecimationCache.h"
+#include "LodPyramid.h"
+#include "MinMaxIndex.h"
+#include "Rasterizer.h"
+#include "RenderStats.h"
+#include "ThreadPool.h"
+#include "TickEngine.h"
+#include "TiledSeries.h"
+#include "expected.hpp"
+#include "wx/affinematrix2d.h"
+#include "wx/dcmemory.h"
+#include "wx/geometry.h"
+#include "wx/graphics.h"
+#include "wx/imagpng.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <span>
+#include <utility>
+#include <variant>
+
+namespace {
+// Image with every pixel transparent, drawn into by the software paths
+// and blitted over the plot area
+wxImage TransparentImage(int width, int height) {
+  wxImage image(width, height);
+  image.InitAlpha();
+  std::fill_n(image.GetAlpha(), static_cast<size_t>(width) * height, 0);
+  return image;
+}
+
+// Scatter marker, rendered once and stamped per occupied pixel
+const chartview::marker &ScatterMarker() {
+  static const chartview::marker marker = Rasterizer::CircleMarker(2.0);
+  return marker;
+}
+
+// Workers for the density histogram of interactive frames, shared by all
+// renderers and only started by the first density frame
+ThreadPool &DensityPool() {
+  static ThreadPool pool;
+  return pool;
+}
+} // namespace
+
+ChartRenderer::ChartRenderer()
+    : m_margins(), m_series{.points = {},
+                            .xMinmax = {0, 0},
+                            .yMinmax = {0, 0},
+                            .xSorted = true,
+                            .xStep = 0,
+                            .timeOrigin = std::nullopt,
+                            .window = std::nullopt,
+                            .archive = nullptr,
+                            .yIndex = {},
+                            .lod = {},
+                            .evicted = 0,
+                            .generation = 0},
+      m_yAutoscale(true),
+      m_lineBackend(chartview::linebackend::graphicspath),
+      m_plotStyle(chartview::plotstyle::line),
+      m_decimation(chartview::decimation::minmax),
+      m_xFormat(chartview::axisformat::number), m_xFormatGeneration(0),
+      m_statsOverlay(false), m_awaitingChunks(false), m_xTicks(80),
+      m_yTicks(40) {
+  // Set default margins
+  auto res = SetMargins({.left = 0.1, .top = 0.1, .right = 0.1, .bottom = 0.1});
+  assert(res && "Default margins are not in span!");
+
+  Publish();
+}
+
+tl::expected<void, std::string>
+ChartRenderer::SetMargins(const chartview::margins &newMargins) {
+  constexpr float minVal = 0.0;
+  constexpr float maxVal = 0.5;
+
+  if (newMargins.left < minVal || newMargins.left > maxVal) {
+    return tl::make_unexpected(
+        std::format("left margin {} outside of span [{}, {}]", newMargins.left,
+                    minVal, maxVal));
+  }
+  if (newMargins.top < minVal || newMargins.top > maxVal) {
+    return tl::make_unexpected(
+        std::format("top margin {} outside of span [{}, {}]", newMargins.top,
+                    minVal, maxVal));
+  }
+  if (newMargins.right < minVal || newMargins.right > maxVal) {
+    return tl::make_unexpected(
+        std::format("right margin {} outside of span [{}, {}]",
+                    newMargins.right, minVal, maxVal));
+  }
+  if (newMargins.bottom < minVal || newMargins.bottom > maxVal) {
+    return tl::make_unexpected(
+        std::format("bottom margin {} outside of span [{}, {}]",
+                    newMargins.bottom, minVal, maxVal));
+  }
+
+  m_margins = newMargins;
+
+  return {};
+}
+
+chartview::margins ChartRenderer::GetMargins() const {
+  return m_margins;
+}
+
+tl::expected<void, std::string>
+ChartRenderer::SetPlotData(const std::vector<double> &xs,
+                           const std::vector<double> &ys) {
+  if (xs.size() != ys.size()) {
+    return tl::make_unexpected(std::format(
+        "plot error: x/y size mismatch x={}, y={}", xs.size(), ys.size()));
+  }
+
+  if (xs.size() == 0 || ys.size() == 0) {
+    return tl::make_unexpected("plot error: x/y size is 0. Use Clear instead");
+  }
+
+  SharedArray<chartview::point> tmp;
+  tmp.resize(xs.size());
+  for (size_t i = 0; i < xs.size(); ++i) {
+    tmp[i] = {.x = xs.at(i), .y = ys.at(i)};
+  }
+
+  std::pair<double, double> _xmax;
+  std::pair<double, double> _ymax;
+  try {
+    _xmax = Extent(xs);
+    _ymax = Extent(ys);
+  } catch (const std::exception &e) {
+    return tl::make_unexpected(
+        std::format("error getting minmax x and y: {}", e.what()));
+  }
+
+  StorePoints(std::move(tmp), _xmax, _ymax, std::nullopt);
+
+  return {};
+}
+
+tl::expected<void, std::string>
+ChartRenderer::SetPlotData(const std::vector<std::int64_t> &timestamps,
+                           const std::vector<double> &ys) {
+  if (timestamps.size() != ys.size()) {
+    return tl::make_unexpected(
+        std::format("plot error: timestamp/y size mismatch t={}, y={}",
+                    timestamps.size(), ys.size()));
+  }
+
+  if (timestamps.empty()) {
+    return tl::make_unexpected("plot error: x/y size is 0. Use Clear instead");
+  }
+
+  // The conversion is part of the copy into points, no extra pass. Offsets
+  // from the origin are exact int64 differences, only then made doubles.
+  const std::int64_t origin = timestamps.front();
+  SharedArray<chartview::point> tmp;
+  tmp.resize(timestamps.size());
+  for (size_t i = 0; i < timestamps.size(); ++i) {
+    tmp[i] = {.x = static_cast<double>(timestamps[i] - origin) * 1e-9,
+              .y = ys[i]};
+  }
+
+  const auto [tMin, tMax] = std::ranges::minmax(timestamps);
+  StorePoints(std::move(tmp),
+              {static_cast<double>(tMin - origin) * 1e-9,
+               static_cast<double>(tMax - origin) * 1e-9},
+              Extent(ys), origin);
+
+  return {};
+}
+
+tl::expected<void, std::string>
+ChartRenderer::AppendPlotData(const std::vector<double> &xs,
+                              const std::vector<double> &ys) {
+  if (m_series.points.empty()) {
+    return SetPlotData(xs, ys);
+  }
+
+  if (m_series.timeOrigin) {
+    return tl::make_unexpected(
+        "plot error: appending plain x to a series with timestamps");
+  }
+
+  if (xs.size() != ys.size()) {
+    return tl::make_unexpected(std::format(
+        "plot error: x/y size mismatch x={}, y={}", xs.size(), ys.size()));
+  }
+
+  if (xs.empty()) {
+    return {};
+  }
+
+  const auto xExtent = Extent(xs);
+  const auto yExtent = Extent(ys);
+
+  // Written past the end of the published points, drawing still reads
+  // the same storage
+  auto &points = m_series.points;
+  const size_t from = points.size();
+  points.reserve(points.size() + xs.size());
+  for (size_t i = 0; i < xs.size(); ++i) {
+    points.push_back({.x = xs[i], .y = ys[i]});
+  }
+  StoreAppended(from, xExtent, yExtent);
+
+  return {};
+}
+
+tl::expected<void, std::string>
+ChartRenderer::AppendPlotData(const std::vector<std::int64_t> &timestamps,
+                              const std::vector<double> &ys) {
+  if (m_series.points.empty()) {
+    return SetPlotData(timestamps, ys);
+  }
+
+  if (!m_series.timeOrigin) {
+    return tl::make_unexpected(
+        "plot error: appending timestamps to a series without timestamps");
+  }
+
+  if (timestamps.size() != ys.size()) {
+    return tl::make_unexpected(
+        std::format("plot error: timestamp/y size mismatch t={}, y={}",
+                    timestamps.size(), ys.size()));
+  }
+
+  if (timestamps.empty()) {
+    return {};
+  }
+
+  const std::int64_t origin = *m_series.timeOrigin;
+  const auto [tMin, tMax] = std::ranges::minmax(timestamps);
+  const auto yExtent = Extent(ys);
+
+  auto &points = m_series.points;
+  const size_t from = points.size();
+  points.reserve(points.size() + timestamps.size());
+  for (size_t i = 0; i < timestamps.size(); ++i) {
+    points.push_back(
+        {.x = static_cast<double>(timestamps[i] - origin) * 1e-9, .y = ys[i]});
+  }
+  StoreAppended(from,
+                {static_cast<double>(tMin - origin) * 1e-9,
+                 static_cast<double>(tMax - origin) * 1e-9},
+                yExtent);
+
+  return {};
+}
+
+void ChartRenderer::StorePoints(SharedArray<chartview::point> points,
+                                const std::pair<double, double> &xExtent,
+                                const std::pair<double, double> &yExtent,
+                                std::optional<std::int64_t> timeOrigin) {
+  m_series.points = std::move(points);
+  m_series.xMinmax = xExtent;
+  m_series.yMinmax = yExtent;
+  m_series.timeOrigin = timeOrigin;
+  m_series.archive.reset();
+  m_series.evicted = 0;
+  ++m_series.generation;
+  UpdateXLayout(0);
+  m_series.yIndex.Build(m_series.points);
+  m_series.lod.Clear();
+  if (m_series.xSorted) {
+    m_series.lod.Append(m_series.points);
+  }
+  if (m_series.window) {
+    m_windowExtent.Clear();
+    for (const auto &point : m_series.points) {
+      m_windowExtent.Push(point.y);
+    }
+    EvictOutsideWindow();
+  }
+  Publish();
+}
+
+void ChartRenderer::StoreAppended(size_t from,
+                                  const std::pair<double, double> &xExtent,
+                                  const std::pair<double, double> &yExtent) {
+  UpdateXLayout(from);
+  m_series.yIndex.Update(m_series.points, from);
+  if (m_series.xSorted) {
+    m_series.lod.Append(std::span<const chartview::point>(m_series.points)
+                            .subspan(from));
+  } else {
+    m_series.lod.Clear();
+  }
+
+  auto &[xMin, xMax] = m_series.xMinmax;
+  auto &[yMin, yMax] = m_series.yMinmax;
+  xMin = std::min(xMin, xExtent.first);
+  xMax = std::max(xMax, xExtent.second);
+  yMin = std::min(yMin, yExtent.first);
+  yMax = std::max(yMax, yExtent.second);
+  if (m_series.window) {
+    for (size_t i = from; i < m_series.points.size(); ++i) {
+      m_windowExtent.Push(m_series.points[i].y);
+    }
+    EvictOutsideWindow();
+  }
+  Publish();
+}
+
+void ChartRenderer::EvictOutsideWindow() {
+  auto &points = m_series.points;
+  if (points.empty()) {
+    return;
+  }
+
+  // Oldest first, so this only looks at the evicted points and one more
+  const double cutoff = m_series.xMinmax.second - *m_series.window;
+  size_t count = 0;
+  while (count < points.size() && points[count].x < cutoff) {
+    ++count;
+  }
+
+  if (count > 0) {
+    points.erase_front(count);
+    m_series.yIndex.Drop(points, count);
+    m_series.evicted += count;
+    m_series.lod.Forget(points.front().x);
+    m_windowExtent.PopFront(count);
+    m_series.xMinmax.first = points.front().x;
+  }
+  m_series.yMinmax = m_windowExtent.Get().value_or(m_series.yMinmax);
+}
+
+void ChartRenderer::Publish() {
+  // The copy shares point and index storage, it costs one allocation and
+  // a few dozen reference counts however long the series is
+  m_published.store(std::make_shared<const chartview::series>(m_series));
+}
+
+tl::expected<bool, std::string>
+ChartRenderer::PushPlotData(chartview::sampleblock block) {
+  // Only what the block says about itself can be checked here, the series
+  // belongs to the owning thread
+  const size_t xCount =
+      std::visit([](const auto &xs) { return xs.size(); }, block.xs);
+  if (xCount != block.ys.size()) {
+    return tl::make_unexpected(
+        std::format("plot error: x/y size mismatch x={}, y={}", xCount,
+                    block.ys.size()));
+  }
+
+  return m_ingest.Push(std::move(block));
+}
+
+tl::expected<size_t, std::string> ChartRenderer::DrainPlotData() {
+  size_t appended = 0;
+  std::optional<std::string> error;
+  for (const auto &block : m_ingest.Drain()) {
+    auto res = std::visit(
+        [&](const auto &xs) { return AppendPlotData(xs, block.ys); },
+        block.xs);
+    if (res) {
+      appended += block.ys.size();
+    } else if (!error) {
+      error = std::move(res.error());
+    }
+  }
+
+  if (error) {
+    return tl::make_unexpected(std::move(*error));
+  }
+  return appended;
+}
+
+void ChartRenderer::Clear() {
+  // Blocks queued before the series was cleared are dropped with it
+  static_cast<void>(m_ingest.Drain());
+  m_series.points.clear();
+  UpdateXLayout(0);
+  m_series.yIndex.Clear();
+  m_series.lod.Clear();
+  m_series.timeOrigin.reset();
+  m_series.archive.reset();
+  m_series.evicted = 0;
+  ++m_series.generation;
+  m_windowExtent.Clear();
+  Publish();
+}
+
+void ChartRenderer::SetPlotArchive(std::shared_ptr<TiledSeries> archive) {
+  Clear();
+  m_series.archive = std::move(archive);
+  Publish();
+}
+
+tl::expected<void, std::string>
+ChartRenderer::SetTimeWindow(std::optional<double> width) {
+  if (width && !(std::isfinite(*width) && *width > 0)) {
+    return tl::make_unexpected(
+        std::format("plot error: time window {} is not positive", *width));
+  }
+
+  m_series.window = width;
+  m_windowExtent.Clear();
+  const auto &points = m_series.points;
+  if (width) {
+    for (const auto &point : points) {
+      m_windowExtent.Push(point.y);
+    }
+    EvictOutsideWindow();
+  } else if (!points.empty()) {
+    // Back to the extent of all points, which the index answers
+    m_series.yMinmax = *m_series.yIndex.Query(points, 0, points.size());
+  }
+  Publish();
+
+  return {};
+}
+
+std::optional<double> ChartRenderer::GetTimeWindow() const {
+  return GetSeries()->window;
+}
+
+tl::expected<void, std::string>
+ChartRenderer::SetPyramidSpill(std::optional<std::filesystem::path> directory,
+                               size_t residentNodes) {
+  auto res = m_series.lod.SetSpill(std::move(directory), residentNodes);
+  if (!res) {
+    return res;
+  }
+
+  if (m_series.xSorted) {
+    m_series.lod.Append(m_series.points);
+  }
+  Publish();
+  return {};
+}
+
+bool ChartRenderer::IsAwaitingChunks() const {
+  return m_awaitingChunks;
+}
+
+std::shared_ptr<const chartview::series> ChartRenderer::GetSeries() const {
+  return m_published.load();
+}
+
+size_t ChartRenderer::GetPointCount() const {
+  const auto data = GetSeries();
+  return data->archive ? data->archive->GetPointCount() : data->points.size();
+}
+
+std::optional<std::int64_t> ChartRenderer::GetTimeOrigin() const {
+  return GetSeries()->timeOrigin;
+}
+
+void ChartRenderer::DrawPlot(wxDC &dc, const wxSize &size,
+                             bool drawSeries) const {
+  ScopedStageTimer frameTimer(m_stats, chartview::renderstage::frame);
+  dc.Clear();
+
+  std::unique_ptr<wxGraphicsContext> gc;
+  {
+    ScopedStageTimer timer(m_stats, chartview::renderstage::gcCreate);
+    gc.reset(wxGraphicsContext::CreateFromUnknownDC(dc));
+  }
+  assert(gc && "failed to create Graphicscontext");
+  gc->SetAntialiasMode(wxAntialiasMode::wxANTIALIAS_DEFAULT);
+
+  DrawPlot(*gc, size, drawSeries);
+}
+
+void ChartRenderer::DrawPlot(wxGraphicsContext &gc, const wxSize &size,
+                             bool drawSeries) const {
+  ScopedStageTimer timer(m_stats, chartview::renderstage::prepare);
+
+  // Buffers of the last frame are dead, rewind their arena
+  const size_t arenaAllocations = m_arena.GetAllocationCount();
+  m_arena.Reset();
+  m_awaitingChunks = false;
+
+  // Created by the first paint instead of the constructor, renderers built
+  // on worker threads for RasterizePlot never touch wx GDI objects
+  if (!m_plotPen.IsOk()) {
+    m_plotPen = wxPen(*wxBLUE);
+    m_gridPen = *wxGREY_PEN;
+    m_bandBrush = wxBrush(wxColour(0, 0, 255, 64));
+  }
+
+  // One version of the data for the whole frame, appends published
+  // meanwhile show up in the next one
+  const auto data = GetSeries();
+  SyncTimeAxis(*data);
+  const auto &points = data->points;
+
+  const wxRect2DDouble plotArea = PlotArea(size);
+
+  timer.Next(chartview::renderstage::background);
+  gc.SetBrush(*wxWHITE_BRUSH);
+  gc.SetPen(*wxBLACK_PEN);
+  gc.DrawRectangle(plotArea);
+
+  // Too small to hold a pixel (a window shrunk into its margins), the
+  // layers below would make empty images
+  const bool tooSmall = plotArea.GetWidth() < 1 || plotArea.GetHeight() < 1;
+  if (!drawSeries || tooSmall || (points.empty() && !data->archive)) {
+    timer.Next(chartview::renderstage::overlay);
+    m_stats.RecordAllocations(m_arena.GetAllocationCount() - arenaAllocations);
+    DrawStatsOverlay(gc);
+    return;
+  }
+
+  timer.Next(chartview::renderstage::grid);
+  const auto view = GetViewport(*data);
+
+  // Transform points to plot area
+  const auto transformationMatrix = PointsToPlotArea(plotArea, view);
+
+  // Draw axis
+  DrawGrid(gc, plotArea, view, transformationMatrix);
+
+  timer.Next(chartview::renderstage::decimate);
+  // Columns reduced ahead of a pan since the last frame
+  if (auto strip = m_prefetcher.Take()) {
+    m_decimationCache.Splice(std::move(*strip));
+  }
+  const auto [first, last] = VisibleRange(*data, view.xLow, view.xHigh);
+
+  if (m_plotStyle == chartview::plotstyle::scatter) {
+    const auto width = static_cast<int>(plotArea.GetWidth());
+    const auto height = static_cast<int>(plotArea.GetHeight());
+    std::pmr::vector<chartview::point> paged(&m_arena);
+    const auto visible =
+        VisiblePoints(*data, first, last, view, width, paged, false);
+
+    // Bin into plot area pixels first, then stamp one marker per occupied
+    // pixel, so millions of points cost no more than the pixels they cover
+    const auto pixels = chartview::OccupiedPixels(
+        visible, PointsToPlotArea(wxRect2DDouble(0, 0, width, height), view),
+        width, height, &m_arena);
+    m_stats.RecordPoints(visible.size(), pixels.size());
+
+    timer.Next(chartview::renderstage::drawPath);
+    wxImage image = TransparentImage(width, height);
+    Rasterizer raster(image);
+    const chartview::rgb colour{.r = m_plotPen.GetColour().Red(),
+                                .g = m_plotPen.GetColour().Green(),
+                                .b = m_plotPen.GetColour().Blue()};
+    for (const auto index : pixels) {
+      raster.Stamp(ScatterMarker(), static_cast<int>(index % width),
+                   static_cast<int>(index / width), colour);
+    }
+
+    gc.DrawBitmap(wxBitmap(image), plotArea.GetX(), plotArea.GetY(),
+                  plotArea.GetWidth(), plotArea.GetHeight());
+  } else if (m_plotStyle == chartview::plotstyle::density) {
+    const auto width = static_cast<int>(plotArea.GetWidth());
+    const auto height = static_cast<int>(plotArea.GetHeight());
+    std::pmr::vector<chartview::point> paged(&m_arena);
+    const auto visible =
+        VisiblePoints(*data, first, last, view, width, paged, false);
+
+    const auto counts = chartview::HitCounts(
+        visible, PointsToPlotArea(wxRect2DDouble(0, 0, width, height), view),
+        width, height, &DensityPool(), &m_arena);
+    m_stats.RecordPoints(visible.size(), counts.size());
+
+    timer.Next(chartview::renderstage::drawPath);
+    wxImage image = TransparentImage(width, height);
+    Rasterizer raster(image);
+    raster.DrawHeatmap(counts, 0, 0, width);
+
+    gc.DrawBitmap(wxBitmap(image), plotArea.GetX(), plotArea.GetY(),
+                  plotArea.GetWidth(), plotArea.GetHeight());
+  } else if (m_plotStyle == chartview::plotstyle::band) {
+    auto columns =
+        ReduceColumns(*data, first, last, view,
+                      static_cast<int>(plotArea.GetWidth()), false);
+    m_stats.RecordPoints(last - first, columns.size());
+
+    timer.Next(chartview::renderstage::transform);
+    ToPixelColumns(columns, transformationMatrix, 0);
+
+    if (!columns.empty()) {
+      // The envelope is one polygon, along the maxima to the right and back
+      // along the minima, so it costs O(columns) whatever the point count
+      timer.Next(chartview::renderstage::pathBuild);
+      const double x0 = plotArea.GetX() + 0.5;
+      auto band = gc.CreatePath();
+      band.MoveToPoint(x0 + columns.front().column, columns.front().max);
+      for (const auto &column : columns) {
+        band.AddLineToPoint(x0 + column.column, column.max);
+      }
+      for (auto it = columns.rbegin(); it != columns.rend(); ++it) {
+        band.AddLineToPoint(x0 + it->column, it->min);
+      }
+      band.CloseSubpath();
+
+      auto mean = gc.CreatePath();
+      mean.MoveToPoint(x0 + columns.front().column, columns.front().mean);
+      for (const auto &column : columns) {
+        mean.AddLineToPoint(x0 + column.column, column.mean);
+      }
+
+      timer.Next(chartview::renderstage::drawPath);
+      gc.Clip(plotArea.GetX(), plotArea.GetY(), plotArea.GetWidth(),
+              plotArea.GetHeight());
+      gc.SetPen(wxNullPen);
+      gc.SetBrush(m_bandBrush);
+      gc.FillPath(band);
+      gc.SetPen(m_plotPen);
+      gc.SetBrush(wxNullBrush);
+      gc.StrokePath(mean);
+      gc.ResetClip();
+    }
+  } else if (m_lineBackend == chartview::linebackend::raster) {
+    auto columns =
+        ReduceColumns(*data, first, last, view,
+                      static_cast<int>(plotArea.GetWidth()), false);
+    m_stats.RecordPoints(last - first, columns.size());
+
+    timer.Next(chartview::renderstage::transform);
+    ToPixelColumns(columns, transformationMatrix, plotArea.GetY());
+
+    // Rasterize the spans into a transparent image covering the plot area
+    // and blit it, bypassing the graphics path API entirely
+    timer.Next(chartview::renderstage::drawPath);
+    wxImage image = TransparentImage(static_cast<int>(plotArea.GetWidth()),
+                                     static_cast<int>(plotArea.GetHeight()));
+    Rasterizer raster(image);
+    raster.DrawColumnSpans(columns, 0,
+                           {.r = m_plotPen.GetColour().Red(),
+                            .g = m_plotPen.GetColour().Green(),
+                            .b = m_plotPen.GetColour().Blue()});
+
+    gc.DrawBitmap(wxBitmap(image), plotArea.GetX(), plotArea.GetY(),
+                  plotArea.GetWidth(), plotArea.GetHeight());
+  } else {
+    // Include one neighbour on each side so lines leaving the viewport are
+    // drawn up to the plot edge
+    const size_t from = first > 0 ? first - 1 : 0;
+    const size_t to = std::min(last + 1, points.size());
+    const auto columns = static_cast<int>(plotArea.GetWidth());
+    std::pmr::vector<chartview::point> paged(&m_arena);
+    const auto visible =
+        VisiblePoints(*data, from, to, view, columns, paged, false);
+
+    // Decimated points are transformed in place, the vertex buffer lives
+    // in the frame arena too
+    std::pmr::vector<chartview::point> decimated(&m_arena);
+    switch (m_decimation) {
+    case chartview::decimation::minmax:
+      if (data->archive) {
+        decimated = chartview::DecimateMinMax(visible, view.xLow, view.xHigh,
+                                              columns, &m_arena);
+      } else if (UseLod(*data, first, last, view, columns)) {
+        EnvelopeVertices(data->lod.Envelope(view.xLow, view.xHigh, columns,
+                                            &m_arena),
+                         view, columns, decimated);
+      } else if (m_decimationCache.Update(*data, from, to, view.xLow,
+                                          view.xHigh, columns)) {
+        decimated = m_decimationCache.MinMaxPoints(&m_arena);
+      } else {
+        decimated = chartview::DecimateMinMax(visible, view.xLow, view.xHigh,
+                                              columns, &m_arena);
+      }
+      break;
+    case chartview::decimation::lttb:
+      if (!data->archive && m_lttb.Update(*data, from, to, view.xLow,
+                                          view.xHigh, columns)) {
+        decimated = m_lttb.Points(&m_arena);
+      } else {
+        decimated = chartview::DecimateLttb(
+            visible, 2 * static_cast<size_t>(std::max(columns, 1)), &m_arena);
+      }
+      break;
+    case chartview::decimation::none:
+      decimated.assign(visible.begin(), visible.end());
+      break;
+    }
+    m_stats.RecordPoints(visible.size(), decimated.size());
+
+    timer.Next(chartview::renderstage::transform);
+    for (auto &point : decimated) {
+      transformationMatrix.TransformPoint(&point.x, &point.y);
+    }
+
+    timer.Next(chartview::renderstage::pathBuild);
+    gc.SetPen(m_plotPen);
+    gc.SetBrush(wxNullBrush);
+
+    auto path = gc.CreatePath();
+    for (const auto &point : decimated) {
+      path.AddLineToPoint(point.x, point.y);
+    }
+
+    timer.Next(chartview::renderstage::drawPath);
+    gc.Clip(plotArea.GetX(), plotArea.GetY(), plotArea.GetWidth(),
+            plotArea.GetHeight());
+    gc.DrawPath(path);
+    gc.ResetClip();
+  }
+
+  // Prepare the next frames of a pan while this one is presented
+  timer.Next(chartview::renderstage::prefetch);
+  m_prefetcher.Speculate(data, view, static_cast<int>(plotArea.GetWidth()),
+                         m_decimationCache, PanPrefetcher::clock::now());
+
+  timer.Next(chartview::renderstage::overlay);
+  m_stats.RecordAllocations(m_arena.GetAllocationCount() - arenaAllocations);
+  DrawStatsOverlay(gc);
+}
+
+void ChartRenderer::RasterizePlot(wxImage &image) const {
+  assert(image.IsOk() && "rasterizing into an invalid image");
+
+  constexpr chartview::rgb white{.r = 255, .g = 255, .b = 255};
+  constexpr chartview::rgb black{.r = 0, .g = 0, .b = 0};
+  constexpr chartview::rgb grey{.r = 128, .g = 128, .b = 128};
+  constexpr chartview::rgb blue{.r = 0, .g = 0, .b = 255};
+
+  Rasterizer raster(image);
+  raster.Fill(white);
+
+  const wxRect2DDouble plotArea = PlotArea(image.GetSize());
+  const auto left = static_cast<int>(plotArea.GetX());
+  const auto top = static_cast<int>(plotArea.GetY());
+  const auto width = static_cast<int>(plotArea.GetWidth());
+  const auto height = static_cast<int>(plotArea.GetHeight());
+
+  const auto data = GetSeries();
+  SyncTimeAxis(*data);
+  const auto &points = data->points;
+  if (width < 1 || height < 1 || (points.empty() && !data->archive)) {
+    raster.DrawRect(left, top, width, height, black);
+    return;
+  }
+
+  m_arena.Reset();
+
+  const auto view = GetViewport(*data);
+  const auto transformationMatrix = PointsToPlotArea(plotArea, view);
+
+  const auto &xTicks = m_xTicks.Ticks(view.xLow, view.xHigh, width);
+  for (double tick : xTicks.values) {
+    double x = tick;
+    double y = view.yLow;
+    transformationMatrix.TransformPoint(&x, &y);
+    raster.DrawVLine(static_cast<int>(x), top, top + height - 1, grey);
+  }
+  const auto &yTicks = m_yTicks.Ticks(view.yLow, view.yHigh, height);
+  for (double tick : yTicks.values) {
+    double x = view.xLow;
+    double y = tick;
+    transformationMatrix.TransformPoint(&x, &y);
+    raster.DrawHLine(left, left + width - 1, static_cast<int>(y), grey);
+  }
+  raster.DrawRect(left, top, width, height, black);
+
+  const auto [first, last] = VisibleRange(*data, view.xLow, view.xHigh);
+  std::pmr::vector<chartview::point> paged(&m_arena);
+  const auto visible =
+      VisiblePoints(*data, first, last, view, width, paged, true);
+
+  raster.SetClip(left, top, width, height);
+  if (m_plotStyle == chartview::plotstyle::scatter) {
+    const auto pixels = chartview::OccupiedPixels(
+        visible, PointsToPlotArea(wxRect2DDouble(0, 0, width, height), view),
+        width, height, &m_arena);
+    for (const auto index : pixels) {
+      raster.Stamp(ScatterMarker(), left + static_cast<int>(index % width),
+                   top + static_cast<int>(index / width), blue);
+    }
+    return;
+  }
+  if (m_plotStyle == chartview::plotstyle::band) {
+    constexpr chartview::rgb lightBlue{.r = 191, .g = 191, .b = 255};
+    auto columns = ReduceColumns(*data, first, last, view, width, true);
+    ToPixelColumns(columns, transformationMatrix, 0);
+    raster.DrawBand(columns, left, lightBlue, blue);
+    return;
+  }
+  if (m_plotStyle == chartview::plotstyle::density) {
+    // Batch jobs already run in parallel, count on the calling thread
+    const auto counts = chartview::HitCounts(
+        visible, PointsToPlotArea(wxRect2DDouble(0, 0, width, height), view),
+        width, height, nullptr, &m_arena);
+    raster.DrawHeatmap(counts, left, top, width);
+    return;
+  }
+
+  auto columns = ReduceColumns(*data, first, last, view, width, true);
+  ToPixelColumns(columns, transformationMatrix, 0);
+  raster.DrawColumnSpans(columns, left, blue);
+}
+
+void ChartRenderer::SetLineBackend(chartview::linebackend backend) {
+  m_lineBackend = backend;
+}
+
+chartview::linebackend ChartRenderer::GetLineBackend() const {
+  return m_lineBackend;
+}
+
+void ChartRenderer::SetPlotStyle(chartview::plotstyle style) {
+  m_plotStyle = style;
+}
+
+chartview::plotstyle ChartRenderer::GetPlotStyle() const {
+  return m_plotStyle;
+}
+
+void ChartRenderer::SetDecimation(chartview::decimation strategy) {
+  m_decimation = strategy;
+}
+
+chartview::decimation ChartRenderer::GetDecimation() const {
+  return m_decimation;
+}
+
+void ChartRenderer::SetXAxisFormat(chartview::axisformat format) {
+  // Only recorded, the ticks belong to drawing and are updated by the
+  // next frame
+  m_xFormat = format;
+  m_xFormatGeneration = GetSeries()->generation;
+}
+
+chartview::axisformat ChartRenderer::GetXAxisFormat() const {
+  return XAxisFormat(*GetSeries());
+}
+
+chartview::axisformat
+ChartRenderer::XAxisFormat(const chartview::series &data) const {
+  // Only a new generation switches, so a format set after SetPlotData is
+  // kept. An empty generation (Clear) keeps the axis until data arrives.
+  if (data.generation == m_xFormatGeneration ||
+      (data.points.empty() && !data.archive)) {
+    return m_xFormat;
+  }
+  if (data.timeOrigin) {
+    return chartview::axisformat::timestamp;
+  }
+  return m_xFormat == chartview::axisformat::timestamp
+             ? chartview::axisformat::number
+             : m_xFormat;
+}
+
+void ChartRenderer::SyncTimeAxis(const chartview::series &data) const {
+  if (data.timeOrigin) {
+    m_xTicks.SetTimeOrigin(*data.timeOrigin);
+  }
+  m_xTicks.SetFormat(XAxisFormat(data));
+}
+
+void ChartRenderer::SetStatsOverlay(bool enabled) {
+  m_statsOverlay = enabled;
+}
+
+RenderStats &ChartRenderer::GetRenderStats() {
+  return m_stats;
+}
+
+const RenderStats &ChartRenderer::GetRenderStats() const {
+  return m_stats;
+}
+
+std::pair<double, double>
+ChartRenderer::Extent(const std::vector<double> &values) {
+  assert(!values.empty() && "extent of empty series");
+  const auto [min, max] = std::ranges::minmax_element(values);
+  return {*min, *max};
+}
+
+wxRect2DDouble ChartRenderer::PlotArea(const wxSize &size) const {
+  wxRect2DDouble fullArea(0, 0, static_cast<double>(size.GetWidth()),
+                          static_cast<double>(size.GetHeight()));
+  wxRect2DDouble plotArea = fullArea;
+  // NOLINTBEGIN Ignore narrowing conversion warning
+  plotArea.Inset(fullArea.GetSize().GetWidth() * m_margins.left,
+                 fullArea.GetSize().GetHeight() * m_margins.top,
+                 fullArea.GetSize().GetWidth() * m_margins.right,
+                 fullArea.GetSize().GetHeight() * m_margins.bottom);
+  // NOLINTEND
+
+  return plotArea;
+}
+
+wxAffineMatrix2D
+ChartRenderer::PointsToPlotArea(const wxRect2DDouble &plotArea,
+                                const chartview::viewport &view) {
+  wxAffineMatrix2D transformationMatrix;
+  transformationMatrix.Translate(plotArea.GetX(),
+                                 plotArea.GetY() + plotArea.GetHeight());
+  transformationMatrix.Scale(plotArea.GetWidth() / (view.xHigh - view.xLow),
+                             plotArea.GetHeight() / (view.yHigh - view.yLow));
+  transformationMatrix.Scale(1, -1);
+  transformationMatrix.Translate(-view.xLow, -view.yLow);
+
+  return transformationMatrix;
+}
+
+tl::expected<void, std::string>
+ChartRenderer::SetViewport(const chartview::viewport &view) {
+  if (!(view.xLow < view.xHigh) || !(view.yLow < view.yHigh)) {
+    return tl::make_unexpected(std::format(
+        "viewport error: empty range x=[{}, {}], y=[{}, {}]", view.xLow,
+        view.xHigh, view.yLow, view.yHigh));
+  }
+
+  m_viewport = view;
+
+  return {};
+}
+
+void ChartRenderer::ResetViewport() {
+  m_viewport.reset();
+}
+
+bool ChartRenderer::HasViewport() const {
+  return m_viewport.has_value();
+}
+
+chartview::viewport ChartRenderer::GetViewport() const {
+  return GetViewport(*GetSeries());
+}
+
+chartview::viewport
+ChartRenderer::GetViewport(const chartview::series &data) const {
+  if (m_viewport && !m_yAutoscale) {
+    return *m_viewport;
+  }
+
+  auto xExtent = std::optional(data.xMinmax);
+  auto yExtent = std::optional(data.yMinmax);
+  if (data.archive) {
+    xExtent = data.archive->XRange();
+    yExtent = data.archive->YRange();
+  } else if (data.points.empty()) {
+    xExtent.reset();
+  }
+  if (!xExtent) {
+    return m_viewport.value_or(
+        chartview::viewport{.xLow = 0, .xHigh = 1, .yLow = 0, .yHigh = 1});
+  }
+
+  // Show all data, or fit y to the visible slice, with y widened to the
+  // nice grid range
+  chartview::viewport view{.xLow = xExtent->first,
+                           .xHigh = xExtent->second,
+                           .yLow = yExtent->first,
+                           .yHigh = yExtent->second};
+  if (data.window) {
+    // Scroll with the newest point, the window is shown at full width
+    // even before it has filled up
+    view.xLow = xExtent->second - *data.window;
+  }
+  if (m_viewport) {
+    view = *m_viewport;
+    const auto [first, last] = VisibleRange(data, view.xLow, view.xHigh);
+    yExtent = data.yIndex.Query(data.points, first, last);
+
+    // Points not held, only the pyramid or the archive knows them. Fit y
+    // to their envelope at a resolution well below a node per pixel.
+    constexpr int envelopeColumns = 256;
+    std::pmr::vector<chartview::bucket> envelope;
+    if (data.archive) {
+      // From the summaries, this runs on the UI thread for every zoom and
+      // pan and must not wait for chunks
+      yExtent.reset();
+      envelope =
+          data.archive->Envelope(view.xLow, view.xHigh, envelopeColumns);
+    } else if (ReachesHistory(data, view)) {
+      envelope = data.lod.Envelope(view.xLow, view.xHigh, envelopeColumns);
+    }
+    for (const auto &column : envelope) {
+      const auto [low, high] =
+          yExtent.value_or(std::pair{column.min, column.max});
+      yExtent =
+          std::pair{std::min(low, column.min), std::max(high, column.max)};
+    }
+    if (!yExtent) {
+      // Nothing visible, keep the last y range
+      return view;
+    }
+    view.yLow = yExtent->first;
+    view.yHigh = yExtent->second;
+  }
+
+  if (!(view.xLow < view.xHigh)) {
+    view.xLow -= 0.5;
+    view.xHigh += 0.5;
+  }
+  if (!(view.yLow < view.yHigh)) {
+    view.yLow -= 0.5;
+    view.yHigh += 0.5;
+  }
+
+  auto [segs, newMin, newMax] = NiceLabels(view.yLow, view.yHigh);
+  if (segs > 1) {
+    view.yLow = newMin;
+    view.yHigh = newMax;
+  }
+
+  return view;
+}
+
+void ChartRenderer::SetYAutoscale(bool enabled) {
+  m_yAutoscale = enabled;
+}
+
+bool ChartRenderer::GetYAutoscale() const {
+  return m_yAutoscale;
+}
+
+void ChartRenderer::Zoom(const wxSize &size, const wxPoint2DDouble &pos,
+                         double factor) {
+  const auto view = GetViewport();
+  const auto plotArea = PlotArea(size);
+
+  // Keep the data point under the cursor fixed
+  const double fx = (pos.m_x - plotArea.GetX()) / plotArea.GetWidth();
+  const double fy = (plotArea.GetBottom() - pos.m_y) / plotArea.GetHeight();
+  const double cx = view.xLow + (fx * (view.xHigh - view.xLow));
+  const double cy = view.yLow + (fy * (view.yHigh - view.yLow));
+
+  auto res = SetViewport({.xLow = cx + ((view.xLow - cx) * factor),
+                          .xHigh = cx + ((view.xHigh - cx) * factor),
+                          .yLow = cy + ((view.yLow - cy) * factor),
+                          .yHigh = cy + ((view.yHigh - cy) * factor)});
+  // Zooming in past double resolution leaves the viewport as it was
+  (void)res;
+}
+
+void ChartRenderer::Pan(const wxSize &size, double dxPixels, double dyPixels) {
+  const auto view = GetViewport();
+  const auto plotArea = PlotArea(size);
+
+  const double dx = dxPixels * (view.xHigh - view.xLow) / plotArea.GetWidth();
+  const double dy = dyPixels * (view.yHigh - view.yLow) / plotArea.GetHeight();
+
+  // Dragging right moves the data right, so the viewport moves left
+  m_prefetcher.Pan(-dx, PanPrefetcher::clock::now());
+  m_viewport = {.xLow = view.xLow - dx,
+                .xHigh = view.xHigh - dx,
+                .yLow = view.yLow + dy,
+                .yHigh = view.yHigh + dy};
+}
+
+std::pair<size_t, size_t> ChartRenderer::VisibleRange(double xLow,
+                                                      double xHigh) const {
+  return VisibleRange(*GetSeries(), xLow, xHigh);
+}
+
+std::pair<size_t, size_t>
+ChartRenderer::VisibleRange(const chartview::series &data, double xLow,
+                            double xHigh) {
+  const auto &points = data.points;
+  const size_t n = points.size();
+  if (!data.xSorted) {
+    return {0, n};
+  }
+
+  auto lowerBound = [&](double x) {
+    return static_cast<size_t>(
+        std::ranges::lower_bound(points, x, {}, &chartview::point::x) -
+        points.begin());
+  };
+  auto upperBound = [&](double x) {
+    return static_cast<size_t>(
+        std::ranges::upper_bound(points, x, {}, &chartview::point::x) -
+        points.begin());
+  };
+
+  if (data.xStep <= 0) {
+    const size_t first = lowerBound(xLow);
+    return {first, std::max(first, upperBound(xHigh))};
+  }
+
+  // Uniform x: compute the index directly, then correct for rounding
+  const double x0 = points.front().x;
+  auto guess = [&](double x) {
+    const double idx = std::floor((x - x0) / data.xStep);
+    return static_cast<size_t>(
+        std::clamp(idx, 0.0, static_cast<double>(n)));
+  };
+
+  size_t first = guess(xLow);
+  while (first > 0 && points[first - 1].x >= xLow) {
+    --first;
+  }
+  while (first < n && points[first].x < xLow) {
+    ++first;
+  }
+
+  size_t last = guess(xHigh);
+  while (last > 0 && points[last - 1].x > xHigh) {
+    --last;
+  }
+  while (last < n && points[last].x <= xHigh) {
+    ++last;
+  }
+
+  return {first, std::max(first, last)};
+}
+
+bool ChartRenderer::UseLod(const chartview::series &data, size_t first,
+                           size_t last, const chartview::viewport &view,
+                           int columns) {
+  if (!data.xSorted || data.lod.empty() || columns <= 0) {
+    return false;
+  }
+  return ReachesHistory(data, view) ||
+         last - first >=
+             4 * LodPyramid::blockSize * static_cast<size_t>(columns);
+}
+
+bool ChartRenderer::ReachesHistory(const chartview::series &data,
+                                   const chartview::viewport &view) {
+  const auto range = data.lod.XRange();
+  if (!data.xSorted || !range || data.points.empty()) {
+    return false;
+  }
+  const double xFirst = data.points.front().x;
+  return view.xLow < xFirst && range->first < xFirst;
+}
+
+std::span<const chartview::point> ChartRenderer::VisiblePoints(
+    const chartview::series &data, size_t first, size_t last,
+    const chartview::viewport &view, int columns,
+    std::pmr::vector<chartview::point> &paged, bool readChunks) const {
+  if (!data.archive) {
+    return {data.points.data() + first, last - first};
+  }
+  auto &archive = *data.archive;
+  if (!archive.Summarizes(view.xLow, view.xHigh, columns)) {
+    if (readChunks) {
+      paged = archive.Points(view.xLow, view.xHigh, &m_arena);
+      return paged;
+    }
+    if (auto cached = archive.CachedPoints(view.xLow, view.xHigh, &m_arena)) {
+      paged = std::move(*cached);
+      return paged;
+    }
+    m_awaitingChunks = true;
+  }
+  EnvelopeVertices(archive.Envelope(view.xLow, view.xHigh, columns, &m_arena),
+                   view, columns, paged);
+  return paged;
+}
+
+void ChartRenderer::EnvelopeVertices(
+    std::span<const chartview::bucket> columns,
+    const chartview::viewport &view, int count,
+    std::pmr::vector<chartview::point> &out) {
+  // The order of the extremes within a column is not known, a vertical
+  // stroke covers the same pixels either way
+  const double dx = (view.xHigh - view.xLow) / count;
+  out.reserve(out.size() + (4 * columns.size()));
+  for (const auto &column : columns) {
+    const double x = view.xLow + ((column.column + 0.5) * dx);
+    out.push_back({.x = x, .y = column.first});
+    out.push_back({.x = x, .y = column.min});
+    out.push_back({.x = x, .y = column.max});
+    out.push_back({.x = x, .y = column.last});
+  }
+}
+
+std::pmr::vector<chartview::bucket>
+ChartRenderer::ReduceColumns(const chartview::series &data, size_t first,
+                             size_t last, const chartview::viewport &view,
+                             int columns, bool readChunks) const {
+  if (data.archive) {
+    auto &archive = *data.archive;
+    if (readChunks || archive.Summarizes(view.xLow, view.xHigh, columns)) {
+      return archive.Columns(view.xLow, view.xHigh, columns, &m_arena);
+    }
+    if (const auto cached =
+            archive.CachedPoints(view.xLow, view.xHigh, &m_arena)) {
+      return chartview::ReduceColumns(*cached, view.xLow, view.xHigh,
+                                      columns, &m_arena);
+    }
+    m_awaitingChunks = true;
+    return archive.Envelope(view.xLow, view.xHigh, columns, &m_arena);
+  }
+  if (UseLod(data, first, last, view, columns)) {
+    return data.lod.Envelope(view.xLow, view.xHigh, columns, &m_arena);
+  }
+  if (m_decimationCache.Update(data, first, last, view.xLow, view.xHigh,
+                               columns)) {
+    return m_decimationCache.Columns(&m_arena);
+  }
+  const std::span<const chartview::point> visible(data.points.data() + first,
+                                                  last - first);
+  return chartview::ReduceColumns(visible, view.xLow, view.xHigh, columns,
+                                  &m_arena);
+}
+
+void ChartRenderer::ToPixelColumns(std::span<chartview::bucket> columns,
+                                   const wxAffineMatrix2D &transform,
+                                   double yOffset) {
+  // The transform has no rotation, so pixel y does not depend on x
+  auto toPixelY = [&](double &y) {
+    double x = 0;
+    transform.TransformPoint(&x, &y);
+    y -= yOffset;
+  };
+  for (auto &column : columns) {
+    toPixelY(column.first);
+    toPixelY(column.min);
+    toPixelY(column.max);
+    toPixelY(column.last);
+    toPixelY(column.mean);
+  }
+}
+
+void ChartRenderer::DrawStatsOverlay(wxGraphicsContext &gc) const {
+  if (!m_statsOverlay) {
+    return;
+  }
+
+  const auto stats = m_stats.GetStatistics();
+
+  gc.SetFont(*wxSMALL_FONT, *wxBLACK);
+  double lineHeight = 0;
+  gc.GetTextExtent("Ag", nullptr, &lineHeight);
+
+  double y = 2;
+  gc.DrawText(std::format("points {} -> {}, {} heap allocations",
+                          stats.pointsIn, stats.pointsOut, stats.allocations),
+              2, y);
+  for (size_t i = 0; i < chartview::renderstageCount; ++i) {
+    const auto &stage = stats.stages.at(i);
+    if (stage.samples == 0) {
+      continue;
+    }
+
+    y += lineHeight;
+    gc.DrawText(
+        std::format("{:<10} min {:.2f} avg {:.2f} p99 {:.2f} ms",
+                    RenderStats::StageName(
+                        static_cast<chartview::renderstage>(i)),
+                    stage.minMs, stage.avgMs, stage.p99Ms),
+        2, y);
+  }
+}
+
+void ChartRenderer::DrawGrid(wxGraphicsContext &gc,
+                             const wxRect2DDouble &plotArea,
+                             const chartview::viewport &view,
+                             const wxAffineMatrix2D &transform) const {
+  constexpr double gap = 4;
+
+  const auto &xTicks =
+      m_xTicks.Ticks(view.xLow, view.xHigh, plotArea.GetWidth());
+  const auto &yTicks =
+      m_yTicks.Ticks(view.yLow, view.yHigh, plotArea.GetHeight());
+
+  gc.SetPen(m_gridPen);
+  for (double tick : xTicks.values) {
+    double x = tick;
+    double y = view.yLow;
+    transform.TransformPoint(&x, &y);
+    std::array<wxPoint2DDouble, 2> points{
+        wxPoint2DDouble(x, plotArea.GetY()),
+        wxPoint2DDouble(x, plotArea.GetBottom())};
+    gc.StrokeLines(points.size(), points.data());
+  }
+  for (double tick : yTicks.values) {
+    double x = view.xLow;
+    double y = tick;
+    transform.TransformPoint(&x, &y);
+    std::array<wxPoint2DDouble, 2> points{
+        wxPoint2DDouble(plotArea.GetX(), y),
+        wxPoint2DDouble(plotArea.GetRight(), y)};
+    gc.StrokeLines(points.size(), points.data());
+  }
+
+  // Labels centred below the x ticks and left of the y ticks
+  gc.SetFont(*wxSMALL_FONT, *wxBLACK);
+  const auto &xLabels = m_xTicks.Measure(gc);
+  for (size_t i = 0; i < xLabels.values.size(); ++i) {
+    double x = xLabels.values[i];
+    double y = view.yLow;
+    transform.TransformPoint(&x, &y);
+    gc.DrawText(xLabels.labels[i], x - (xLabels.widths[i] / 2),
+                plotArea.GetBottom() + gap);
+  }
+  const auto &yLabels = m_yTicks.Measure(gc);
+  for (size_t i = 0; i < yLabels.values.size(); ++i) {
+    double x = view.xLow;
+    double y = yLabels.values[i];
+    transform.TransformPoint(&x, &y);
+    gc.DrawText(yLabels.labels[i], plotArea.GetX() - yLabels.widths[i] - gap,
+                y - (yLabels.height / 2));
+  }
+}
+
+void ChartRenderer::UpdateXLayout(size_t from) {
+  const auto &points = m_series.points;
+  auto &xSorted = m_series.xSorted;
+  auto &xStep = m_series.xStep;
+  const size_t n = points.size();
+  if (from == 0) {
+    xSorted = true;
+    xStep = n > 1 ? points[1].x - points[0].x : 0.0;
+    from = 1;
+  }
+  if (xSorted && n > 1 && xStep == 0) {
+    // Second point of a series that started with a single point
+    xStep = points[1].x - points[0].x;
+  }
+
+  const double x0 = n > 0 ? points.front().x : 0.0;
+  for (size_t i = from; i < n && xSorted; ++i) {
+    if (points[i].x < points[i - 1].x) {
+      xSorted = false;
+      xStep = 0;
+      continue;
+    }
+
+    const double expected = x0 + (static_cast<double>(i) * xStep);
+    if (xStep > 0 && std::abs(points[i].x - expected) > 0.01 * xStep) {
+      xStep = -1; // sorted but not uniform
+    }
+  }
+}
+
+tl::expected<wxImage, std::string>
+ChartRenderer::RenderToImage(int width, int height) const {
+  if (width <= 0 || height <= 0) {
+    return tl::make_unexpected(
+        std::format("render error: invalid image size {}x{}", width, height));
+  }
+
+  wxBitmap bitmap(width, height, 24);
+  if (!bitmap.IsOk()) {
+    return tl::make_unexpected(std::format(
+        "render error: failed to create {}x{} bitmap", width, height));
+  }
+
+  {
+    wxMemoryDC dc(bitmap);
+    dc.SetBackground(*wxWHITE_BRUSH);
+    DrawPlot(dc, wxSize(width, height));
+    dc.SelectObject(wxNullBitmap);
+  }
+
+  return bitmap.ConvertToImage();
+}
+
+tl::expected<void, std::string>
+ChartRenderer::RenderToPng(const wxString &path, int width, int height) const {
+  auto image = RenderToImage(width, height);
+  if (!image) {
+    return tl::make_unexpected(image.error());
+  }
+
+  if (wxImage::FindHandler(wxBITMAP_TYPE_PNG) == nullptr) {
+    wxImage::AddHandler(new wxPNGHandler);
+  }
+
+  if (!image->SaveFile(path, wxBITMAP_TYPE_PNG)) {
+    return tl::make_unexpected(std::format("render error: failed to save {}",
+                                           path.ToStdString()));
+  }
+
+  return {};
+}
+
+std::tuple<int, double, double>
+ChartRenderer::NiceLabels(double origLow, double origHigh, int maxSegments) {
+  constexpr std::array<double, 7> rangeMults{0.2, 0.25, 0.5, 1.0,
+                                             2.0, 2.5,  5.0};
+
+  const double scale =
+      std::pow(10.0, std::floor(std::log10(origHigh - origLow)));
+
+  for (auto r : rangeMults) {
+    double stepSize = r * scale;
+    double low = std::floor(origLow / stepSize) * stepSize;
+    double high = std::ceil(origHigh / stepSize) * stepSize;
+
+    auto segments = static_cast<int>(round((high - low) / stepSize));
+
+    if (segments <= maxSegments) {
+      return std::make_tuple(segments, low, high);
+    }
+  }
+
+  // return some defaults in case rangeMults and maxSegments are mismatched
+  return std::make_tuple(10, origLow, origHigh);
+}
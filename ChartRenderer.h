@@ -0,0 +1,372 @@
+#pragma once
+
+#include <wx/wx.h>
+
+#include "DecimationCache.h"
+#include "FrameArena.h"
+#include "LodPyramid.h"
+#include "MinMaxIndex.h"
+#include "PanPrefetcher.h"
+#include "RenderStats.h"
+#include "SampleQueue.h"
+#include "SharedArray.h"
+#include "SlidingMinMax.h"
+#include "StreamingLttb.h"
+#include "TickEngine.h"
+#include "expected.hpp"
+#include "wx/affinematrix2d.h"
+#include "wx/geometry.h"
+#include "wx/graphics.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+class TiledSeries;
+
+namespace chartview {
+struct margins {
+  float left;
+  float top;
+  float right;
+  float bottom;
+};
+
+struct point {
+  double x;
+  double y;
+};
+
+// Visible data range of the plot area
+struct viewport {
+  double xLow;
+  double xHigh;
+  double yLow;
+  double yHigh;
+};
+
+struct bucket;
+
+// One published version of the plot data, never changed once published.
+// Drawing holds a version for the whole frame while appends on another
+// thread publish newer ones, which share the point storage.
+struct series {
+  SharedArray<point> points;
+  std::pair<double, double> xMinmax;
+  std::pair<double, double> yMinmax;
+  // x layout, decides how VisibleRange finds the visible slice. xStep is the
+  // spacing of uniform x, 0 while unknown and -1 for non uniform x.
+  bool xSorted;
+  double xStep;
+  std::optional<std::int64_t> timeOrigin;
+  // Width of the sliding x window, points older than the newest x minus
+  // window are evicted. yMinmax is the extent of the window then.
+  std::optional<double> window;
+  // Out-of-core points, drawn instead of points while set
+  std::shared_ptr<TiledSeries> archive;
+  // Answers the y extent of the visible slice without scanning it
+  MinMaxIndex yIndex;
+  // Summaries of the points held, for drawing zoomed out views, and of
+  // the evicted ones too while spilling. Kept while x is sorted.
+  LodPyramid lod;
+  // Points evicted since the generation started. Adding it to an index
+  // gives a position that stays put while the window moves.
+  size_t evicted;
+  // Counts SetPlotData and Clear calls, within one generation points are
+  // only appended and evicted. The x axis follows the time origin of a new
+  // generation.
+  size_t generation;
+};
+
+// How line series are drawn by DrawPlot. graphicspath strokes an antialiased
+// wxGraphicsPath, raster draws per column min/max spans into a pixel buffer
+// and blits it, which is much cheaper for dense series.
+enum class linebackend : std::uint8_t { graphicspath, raster };
+
+// How the graphicspath backend thins out line series before building the
+// path. minmax keeps the first, lowest, highest and last point per pixel
+// column and draws the same pixels as all points, lttb keeps two points per
+// column picked by Largest-Triangle-Three-Buckets for thin previews and
+// none strokes every visible point.
+enum class decimation : std::uint8_t { minmax, lttb, none };
+
+// What DrawPlot draws for the series. line connects the points, scatter
+// stamps a marker on every pixel hit by at least one point, density
+// colours each pixel by the log of the number of points hitting it and band
+// fills the per column min/max envelope with the mean line on top.
+enum class plotstyle : std::uint8_t { line, scatter, density, band };
+} // namespace chartview
+
+// Window independent part of the chart. Holds the plot data and knows how to
+// draw it into any wxDC or wxGraphicsContext, so the same code serves
+// ChartView::OnPaint and offscreen rendering to images.
+class ChartRenderer {
+public:
+  ChartRenderer();
+
+  tl::expected<void, std::string>
+  SetMargins(const chartview::margins &newMargins);
+
+  [[nodiscard]] chartview::margins GetMargins() const;
+
+  // The data setters below (SetPlotData, AppendPlotData, DrainPlotData,
+  // Clear) may run on one thread while another thread draws, drawing sees
+  // each change complete or not at all.
+  tl::expected<void, std::string> SetPlotData(const std::vector<double> &xs,
+                                              const std::vector<double> &ys);
+  // Timestamps in nanoseconds since the epoch. x is stored as seconds after
+  // the first timestamp, so precision does not degrade with the distance
+  // from 1970, and the x axis switches to timestamp labels.
+  tl::expected<void, std::string>
+  SetPlotData(const std::vector<std::int64_t> &timestamps,
+              const std::vector<double> &ys);
+  // Append points after the existing ones, extents are updated from the
+  // new points only. Plain x and timestamps cannot be mixed in one series.
+  tl::expected<void, std::string>
+  AppendPlotData(const std::vector<double> &xs, const std::vector<double> &ys);
+  tl::expected<void, std::string>
+  AppendPlotData(const std::vector<std::int64_t> &timestamps,
+                 const std::vector<double> &ys);
+  // Safe from any thread, for acquisition threads feeding the series. The
+  // block is queued without locks and appended by the next DrainPlotData.
+  // Returns true if the queue was empty, i.e. the owner should be told
+  // that data is waiting.
+  tl::expected<bool, std::string> PushPlotData(chartview::sampleblock block);
+  // Append the queued blocks in push order, on the thread that owns the
+  // renderer. Returns the number of points appended. Blocks that cannot be
+  // appended are skipped, the first error is returned after the others
+  // were appended.
+  tl::expected<size_t, std::string> DrainPlotData();
+  void Clear();
+  // Draw an out-of-core archive instead of points held in memory. It is
+  // summarized when zoomed out and paged in when zoomed in, and may keep
+  // growing through TiledSeries::Append. Setting or appending plot data
+  // and Clear go back to points in memory.
+  void SetPlotArchive(std::shared_ptr<TiledSeries> archive);
+
+  // Strip chart mode, keep only the points within width (in x units,
+  // seconds for timestamps) of the newest x and show that window. x is
+  // expected to grow. Eviction and the window's y extent cost amortized
+  // O(1) per point. Without a width (the default) all points are kept.
+  // Memory stays in proportion to the window unless SetPyramidSpill keeps
+  // the history, which costs about 2 bytes per point ever appended, on
+  // disk for all but the newest nodes.
+  tl::expected<void, std::string> SetTimeWindow(std::optional<double> width);
+  [[nodiscard]] std::optional<double> GetTimeWindow() const;
+
+  // Keep summaries of the points a time window evicts in the level of
+  // detail pyramid, so zoomed out views can still show them: each level
+  // keeps its newest residentNodes in memory and spills older ones to
+  // files in directory. Without a directory (the default) the pyramid
+  // drops its summaries with the points. Rebuilds the pyramid from the
+  // points held, the summaries of evicted points are lost.
+  tl::expected<void, std::string>
+  SetPyramidSpill(std::optional<std::filesystem::path> directory,
+                  size_t residentNodes = 4096);
+
+  // Whether the last DrawPlot showed archive chunks from their summaries
+  // because they were still being read. A later frame shows them in full.
+  [[nodiscard]] bool IsAwaitingChunks() const;
+
+  // The plot data as of the last change, consistent and safe to read from
+  // any thread for as long as it is held
+  [[nodiscard]] std::shared_ptr<const chartview::series> GetSeries() const;
+
+  [[nodiscard]] size_t GetPointCount() const;
+  // Timestamp x = 0 stands for, set by timestamp plot data. Viewport x
+  // values are seconds relative to it.
+  [[nodiscard]] std::optional<std::int64_t> GetTimeOrigin() const;
+
+  // Draw frame, grid and (optionally) the series into the given area
+  void DrawPlot(wxGraphicsContext &gc, const wxSize &size,
+                bool drawSeries = true) const;
+  void DrawPlot(wxDC &dc, const wxSize &size, bool drawSeries = true) const;
+
+  // Render offscreen using a wxMemoryDC, no window is needed
+  [[nodiscard]] tl::expected<wxImage, std::string>
+  RenderToImage(int width, int height) const;
+  tl::expected<void, std::string> RenderToPng(const wxString &path, int width,
+                                              int height) const;
+
+  // Software rasterization into the image's RGB buffer. Uses no wx GDI
+  // objects, so it may run on worker threads, but it updates the frame
+  // arena, decimation cache and tick caches like DrawPlot: each thread
+  // needs its own renderer, as BatchRenderer makes one per job.
+  void RasterizePlot(wxImage &image) const;
+
+  // Restrict drawing to a data range. Without a viewport all data is shown
+  // with y widened to the nice grid range. While y autoscale is on only the
+  // x range of the viewport is used.
+  tl::expected<void, std::string> SetViewport(const chartview::viewport &view);
+  void ResetViewport();
+  [[nodiscard]] bool HasViewport() const;
+  // The range actually drawn, explicit or automatic
+  [[nodiscard]] chartview::viewport GetViewport() const;
+
+  // Fit y to the points inside the x range of the viewport, on by default
+  void SetYAutoscale(bool enabled);
+  [[nodiscard]] bool GetYAutoscale() const;
+
+  // Zoom by factor (< 1 zooms in) around the pixel position pos, for a plot
+  // drawn at size
+  void Zoom(const wxSize &size, const wxPoint2DDouble &pos, double factor);
+  // Move the viewport with the data by a pixel offset
+  void Pan(const wxSize &size, double dxPixels, double dyPixels);
+
+  // Index range [first, last) of the points with x in [xLow, xHigh], empty
+  // if xHigh < xLow. Uses index arithmetic for uniformly spaced x, binary
+  // search for sorted x and the whole series otherwise.
+  [[nodiscard]] std::pair<size_t, size_t> VisibleRange(double xLow,
+                                                       double xHigh) const;
+
+  void SetLineBackend(chartview::linebackend backend);
+  [[nodiscard]] chartview::linebackend GetLineBackend() const;
+
+  void SetPlotStyle(chartview::plotstyle style);
+  [[nodiscard]] chartview::plotstyle GetPlotStyle() const;
+
+  void SetDecimation(chartview::decimation strategy);
+  [[nodiscard]] chartview::decimation GetDecimation() const;
+
+  // Label x ticks as plain numbers or as a time axis in seconds
+  void SetXAxisFormat(chartview::axisformat format);
+  [[nodiscard]] chartview::axisformat GetXAxisFormat() const;
+
+  // Per stage paint timings and point counts of the last frame, optionally
+  // drawn as text in the top left corner of the plot
+  void SetStatsOverlay(bool enabled);
+  [[nodiscard]] RenderStats &GetRenderStats();
+  [[nodiscard]] const RenderStats &GetRenderStats() const;
+
+  // Round [origLow, origHigh] out to nice numbers split into at most
+  // maxSegments segments, returns the segment count and the nice range
+  static std::tuple<int, double, double>
+  NiceLabels(double origLow, double origHigh, int maxSegments = 6);
+
+  // Individual pipeline stages, public so they can be benchmarked in
+  // isolation
+  static std::pair<double, double> Extent(const std::vector<double> &values);
+  [[nodiscard]] wxRect2DDouble PlotArea(const wxSize &size) const;
+  static wxAffineMatrix2D PointsToPlotArea(const wxRect2DDouble &plotArea,
+                                           const chartview::viewport &view);
+
+private:
+  chartview::margins m_margins;
+
+  // Series being written, only touched by the data setters. Every change
+  // is published as a copy, which shares the storage, for drawing to pick
+  // up, so data may be set on one thread while drawing runs on another.
+  chartview::series m_series;
+  std::atomic<std::shared_ptr<const chartview::series>> m_published;
+  // y extent of the window, maintained while a time window is set
+  SlidingMinMax m_windowExtent;
+
+  // Blocks pushed by producer threads, waiting for DrainPlotData
+  SampleQueue m_ingest;
+
+  std::optional<chartview::viewport> m_viewport;
+  bool m_yAutoscale;
+
+  chartview::linebackend m_lineBackend;
+  chartview::plotstyle m_plotStyle;
+  chartview::decimation m_decimation;
+  // Format given to SetXAxisFormat and the series generation it was given
+  // for, DrawPlot applies it to the ticks
+  chartview::axisformat m_xFormat;
+  size_t m_xFormatGeneration;
+
+  bool m_statsOverlay;
+  mutable RenderStats m_stats;
+
+  // Pens and brushes of DrawPlot, kept across frames
+  mutable wxPen m_plotPen;
+  mutable wxPen m_gridPen;
+  mutable wxBrush m_bandBrush;
+
+  // Owns the per frame buffers (buckets, decimated vertices, pixel grids),
+  // rewound at the start of every frame instead of freed
+  mutable FrameArena m_arena;
+  // Set by DrawPlot when archive chunks it needed were not cached yet
+  mutable bool m_awaitingChunks;
+  // Column reduction carried over between frames for append only data
+  mutable DecimationCache m_decimationCache;
+  // LTTB picks carried over between frames for append only data
+  mutable StreamingLttb m_lttb;
+  // Prepares the data ahead of a pan, between frames
+  mutable PanPrefetcher m_prefetcher;
+
+  // Memoized across frames, drawing is const but ticks only change with
+  // the viewport or size
+  mutable TickEngine m_xTicks;
+  mutable TickEngine m_yTicks;
+
+  // Convert bucket y values to pixels, relative to yOffset
+  static void ToPixelColumns(std::span<chartview::bucket> columns,
+                             const wxAffineMatrix2D &transform, double yOffset);
+  void DrawStatsOverlay(wxGraphicsContext &gc) const;
+  void DrawGrid(wxGraphicsContext &gc, const wxRect2DDouble &plotArea,
+                const chartview::viewport &view,
+                const wxAffineMatrix2D &transform) const;
+  // Format of the x axis for data: the one set for its generation, or for
+  // a newer generation timestamps if it has a time origin
+  [[nodiscard]] chartview::axisformat
+  XAxisFormat(const chartview::series &data) const;
+  // Bring the x ticks to the format and time origin of data
+  void SyncTimeAxis(const chartview::series &data) const;
+  [[nodiscard]] chartview::viewport
+  GetViewport(const chartview::series &data) const;
+  static std::pair<size_t, size_t>
+  VisibleRange(const chartview::series &data, double xLow, double xHigh);
+  // Whether the view is drawn from the level of detail pyramid, because
+  // it reaches back beyond the points held or is zoomed out so far that
+  // each column would reduce several blocks of points
+  static bool UseLod(const chartview::series &data, size_t first,
+                     size_t last, const chartview::viewport &view,
+                     int columns);
+  // Whether the view starts before the points held and the pyramid still
+  // covers evicted points there
+  static bool ReachesHistory(const chartview::series &data,
+                             const chartview::viewport &view);
+  // The points drawn for [first, last): a slice of the points held, or
+  // for archives the points paged in, or when zoomed out the column
+  // envelope as first, min, max and last vertices. Paged points are put
+  // into paged. Without readChunks archive chunks are not read on the
+  // calling thread, the envelope stands in for them until the prefetch
+  // thread has read them.
+  std::span<const chartview::point>
+  VisiblePoints(const chartview::series &data, size_t first, size_t last,
+                const chartview::viewport &view, int columns,
+                std::pmr::vector<chartview::point> &paged,
+                bool readChunks) const;
+  // Vertical strokes at the column centres through each column's first,
+  // lowest, highest and last y, for views summarized per column
+  static void EnvelopeVertices(std::span<const chartview::bucket> columns,
+                               const chartview::viewport &view, int count,
+                               std::pmr::vector<chartview::point> &out);
+  // ReduceColumns over points [first, last), served by the archive, the
+  // pyramid or the decimation cache where they apply. readChunks as for
+  // VisiblePoints.
+  std::pmr::vector<chartview::bucket>
+  ReduceColumns(const chartview::series &data, size_t first, size_t last,
+                const chartview::viewport &view, int columns,
+                bool readChunks) const;
+  void UpdateXLayout(size_t from);
+  // Drop the points that left the time window
+  void EvictOutsideWindow();
+  void Publish();
+  // Replace the points or finish appending points from index from on, then
+  // publish the series
+  void StorePoints(SharedArray<chartview::point> points,
+                   const std::pair<double, double> &xExtent,
+                   const std::pair<double, double> &yExtent,
+                   std::optional<std::int64_t> timeOrigin);
+  void StoreAppended(size_t from, const std::pair<double, double> &xExtent,
+                     const std::pair<double, double> &yExtent);
+};
@@ -0,0 +1,417 @@
+#include <wx/wx.h>
+
+#include "ChartView.h"
+#include "wx/dcmemory.h"
+#include "wx/timer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+// windows.h must come first
+#include <psapi.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Headless soak harness for ChartView. Replays a trace of resize, data and
+// margin events against a hidden view in real time, while a display timer
+// paints frames through ChartView::Render the way the window would.
+// Reports frame time and event-to-frame latency distributions, dropped
+// display frames and peak RSS.
+//
+// Trace format, one event per line, '#' starts a comment:
+//   <time ms> data <points>            replace the series with a sine
+//   <time ms> append <points>          append points continuing the sine
+//   <time ms> resize <width> <height>  resize the view
+//   <time ms> margins <l> <t> <r> <b>  set margins
+//   <time ms> end                      end of trace (optional)
+//
+// usage: ChartStress [trace file] [--loops=<n>] [--fps=<n>]
+// Without a trace file a built-in resize and append storm is replayed.
+class ChartStress : public wxApp {
+  bool OnInit() override;
+  int OnRun() override;
+
+  struct traceevent {
+    long timeMs;
+    std::string command;
+    std::vector<double> args;
+  };
+
+  std::vector<traceevent> m_trace;
+  int m_loops = 1;
+  int m_fps = 60;
+
+  ChartView *m_view = nullptr;
+  wxTimer m_eventTimer;
+  wxTimer m_displayTimer;
+
+  size_t m_nextEvent = 0;
+  int m_loop = 0;
+  std::chrono::steady_clock::time_point m_start;
+  size_t m_samples = 0;
+
+  std::optional<std::chrono::steady_clock::time_point> m_pendingSince;
+  bool m_wasResizing = false;
+  std::optional<std::chrono::steady_clock::time_point> m_lastTick;
+
+  std::vector<double> m_frameMs;
+  std::vector<double> m_latencyMs;
+  size_t m_droppedFrames = 0;
+  size_t m_blankFrames = 0;
+  size_t m_events = 0;
+  int m_exitCode = 0;
+  bool m_finishing = false;
+
+  tl::expected<void, std::string> LoadTrace(const std::string &path);
+  void BuiltinTrace();
+
+  void OnEventTimer(wxTimerEvent &evt);
+  void OnDisplayTimer(wxTimerEvent &evt);
+  void ApplyEvent(const traceevent &event);
+  void ScheduleNextEvent();
+  void Finish();
+  void Report() const;
+
+  std::pair<std::vector<double>, std::vector<double>> MakeSamples(size_t n);
+};
+
+// NOLINTNEXTLINE
+wxIMPLEMENT_APP_CONSOLE(ChartStress);
+
+namespace {
+size_t PeakRssBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters{};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                           sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#elif defined(__APPLE__)
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<size_t>(usage.ru_maxrss); // bytes on macOS
+#elif defined(__unix__)
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+#else
+  return 0;
+#endif
+}
+
+double Percentile(std::vector<double> values, double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  const auto idx = std::min(
+      values.size() - 1,
+      static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5));
+  std::ranges::nth_element(values, values.begin() + idx);
+  return values[idx];
+}
+
+double MsSince(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - t)
+      .count();
+}
+} // namespace
+
+bool ChartStress::OnInit() {
+  std::optional<std::string> tracePath;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = wxString(argv[i]).ToStdString();
+    try {
+      if (arg.starts_with("--loops=")) {
+        m_loops = std::max(std::stoi(arg.substr(8)), 1);
+      } else if (arg.starts_with("--fps=")) {
+        m_fps = std::max(std::stoi(arg.substr(6)), 1);
+      } else if (!arg.starts_with("--")) {
+        tracePath = arg;
+      } else {
+        std::cerr << std::format("unknown option {}\n", arg);
+        return false;
+      }
+    } catch (const std::exception &e) {
+      std::cerr << std::format("invalid option {}: {}\n", arg, e.what());
+      return false;
+    }
+  }
+
+  if (tracePath) {
+    auto res = LoadTrace(*tracePath);
+    if (!res) {
+      std::cerr << res.error() << '\n';
+      return false;
+    }
+  } else {
+    BuiltinTrace();
+  }
+
+  // Never shown, frames are painted into a memory DC by the display timer
+  m_view = new ChartView(nullptr, wxID_ANY, "ChartStress");
+
+  m_eventTimer.SetOwner(this);
+  Bind(wxEVT_TIMER, &ChartStress::OnEventTimer, this, m_eventTimer.GetId());
+  m_displayTimer.SetOwner(this);
+  Bind(wxEVT_TIMER, &ChartStress::OnDisplayTimer, this,
+       m_displayTimer.GetId());
+
+  m_start = std::chrono::steady_clock::now();
+  m_displayTimer.Start(1000 / m_fps);
+  ScheduleNextEvent();
+
+  return true;
+}
+
+int ChartStress::OnRun() {
+  // The exit code of the main loop is wx's, not the verdict of the run
+  static_cast<void>(wxApp::OnRun());
+  return m_exitCode;
+}
+
+tl::expected<void, std::string>
+ChartStress::LoadTrace(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    return tl::make_unexpected(std::format("failed to open trace {}", path));
+  }
+
+  std::string line;
+  size_t lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    line = line.substr(0, line.find('#'));
+
+    std::istringstream words(line);
+    traceevent event;
+    if (!(words >> event.timeMs)) {
+      continue; // blank or comment line
+    }
+    if (!(words >> event.command)) {
+      return tl::make_unexpected(
+          std::format("{}:{}: missing command", path, lineNo));
+    }
+    double arg = 0;
+    while (words >> arg) {
+      event.args.push_back(arg);
+    }
+
+    const size_t expected = event.command == "data"      ? 1
+                            : event.command == "append"  ? 1
+                            : event.command == "resize"  ? 2
+                            : event.command == "margins" ? 4
+                            : event.command == "end"     ? 0
+                                                         : SIZE_MAX;
+    if (expected == SIZE_MAX) {
+      return tl::make_unexpected(std::format("{}:{}: unknown command {}", path,
+                                             lineNo, event.command));
+    }
+    if (event.args.size() != expected) {
+      return tl::make_unexpected(
+          std::format("{}:{}: {} expects {} arguments", path, lineNo,
+                      event.command, expected));
+    }
+
+    m_trace.push_back(std::move(event));
+  }
+
+  std::ranges::stable_sort(m_trace, {}, &traceevent::timeMs);
+  if (m_trace.empty()) {
+    return tl::make_unexpected(std::format("trace {} has no events", path));
+  }
+
+  return {};
+}
+
+void ChartStress::BuiltinTrace() {
+  m_trace.push_back({.timeMs = 0, .command = "data", .args = {1'000'000}});
+  m_trace.push_back({.timeMs = 0, .command = "resize", .args = {800, 600}});
+
+  // Drag resize storm, a size event every 5 ms for one second
+  for (long t = 200; t < 1200; t += 5) {
+    const double phase = static_cast<double>(t - 200) / 1000.0;
+    m_trace.push_back({.timeMs = t,
+                       .command = "resize",
+                       .args = {800 + (400 * phase), 600 + (200 * phase)}});
+  }
+
+  // Acquisition at 1 kHz delivered in 1 ms blocks
+  for (long t = 1500; t < 3500; ++t) {
+    m_trace.push_back({.timeMs = t, .command = "append", .args = {100}});
+  }
+
+  m_trace.push_back(
+      {.timeMs = 3600, .command = "margins", .args = {0.15, 0.1, 0.1, 0.15}});
+  m_trace.push_back({.timeMs = 4000, .command = "end", .args = {}});
+}
+
+void ChartStress::ScheduleNextEvent() {
+  if (m_nextEvent >= m_trace.size()) {
+    if (++m_loop >= m_loops) {
+      Finish();
+      return;
+    }
+    m_nextEvent = 0;
+  }
+
+  const long loopLength = m_trace.back().timeMs + 1;
+  const long due = (m_loop * loopLength) + m_trace[m_nextEvent].timeMs;
+  const auto delay = static_cast<int>(
+      std::max(0.0, static_cast<double>(due) - MsSince(m_start)));
+
+  m_eventTimer.StartOnce(std::max(delay, 1));
+}
+
+void ChartStress::OnEventTimer(wxTimerEvent & /*evt*/) {
+  if (m_finishing) {
+    m_displayTimer.Stop();
+    Report();
+    m_view->Destroy();
+    ExitMainLoop();
+    return;
+  }
+
+  const long loopLength = m_trace.back().timeMs + 1;
+  const double now =
+      MsSince(m_start) - static_cast<double>(m_loop * loopLength);
+
+  // Apply every event that is due, the timer may fire late
+  while (m_nextEvent < m_trace.size() &&
+         static_cast<double>(m_trace[m_nextEvent].timeMs) <= now) {
+    ApplyEvent(m_trace[m_nextEvent]);
+    ++m_nextEvent;
+  }
+
+  ScheduleNextEvent();
+}
+
+void ChartStress::ApplyEvent(const traceevent &event) {
+  ++m_events;
+  if (!m_pendingSince) {
+    m_pendingSince = std::chrono::steady_clock::now();
+  }
+
+  tl::expected<void, std::string> res;
+  if (event.command == "data") {
+    m_samples = 0;
+    auto [xs, ys] = MakeSamples(static_cast<size_t>(event.args[0]));
+    res = m_view->SetPlotData(xs, ys);
+  } else if (event.command == "append") {
+    auto [xs, ys] = MakeSamples(static_cast<size_t>(event.args[0]));
+    res = m_view->AppendPlotData(xs, ys);
+  } else if (event.command == "resize") {
+    const wxSize size(static_cast<int>(event.args[0]),
+                      static_cast<int>(event.args[1]));
+    m_view->SetClientSize(size);
+    // Hidden windows do not reliably get size events, send one explicitly
+    wxSizeEvent sizeEvent(m_view->GetSize(), m_view->GetId());
+    sizeEvent.SetEventObject(m_view);
+    m_view->ProcessWindowEvent(sizeEvent);
+  } else if (event.command == "margins") {
+    res = m_view->SetMargins({.left = static_cast<float>(event.args[0]),
+                              .top = static_cast<float>(event.args[1]),
+                              .right = static_cast<float>(event.args[2]),
+                              .bottom = static_cast<float>(event.args[3])});
+  }
+
+  if (!res) {
+    std::cerr << std::format("{} at {} ms: {}\n", event.command, event.timeMs,
+                             res.error());
+    m_exitCode = 1;
+  }
+}
+
+void ChartStress::OnDisplayTimer(wxTimerEvent & /*evt*/) {
+  const auto tick = std::chrono::steady_clock::now();
+  const double interval = 1000.0 / m_fps;
+  if (m_lastTick) {
+    const double sinceLast =
+        std::chrono::duration<double, std::milli>(tick - *m_lastTick).count();
+    // Vsync ticks that passed while the previous frame was still busy
+    const auto missed = static_cast<size_t>(sinceLast / interval);
+    m_droppedFrames += missed > 1 ? missed - 1 : 0;
+  }
+  m_lastTick = tick;
+
+  // The end of a resize needs a full repaint even without a new event
+  const bool resizing = m_view->IsResizing();
+  const bool resizeSettled = m_wasResizing && !resizing;
+  m_wasResizing = resizing;
+  if (!m_pendingSince && !resizeSettled) {
+    return;
+  }
+
+  const wxSize size = m_view->GetClientSize();
+  if (size.GetWidth() <= 0 || size.GetHeight() <= 0) {
+    return;
+  }
+
+  {
+    wxBitmap bitmap(size.GetWidth(), size.GetHeight(), 24);
+    wxMemoryDC dc(bitmap);
+    m_view->Render(dc);
+    dc.SelectObject(wxNullBitmap);
+  }
+
+  m_frameMs.push_back(MsSince(tick));
+  if (m_pendingSince) {
+    m_latencyMs.push_back(MsSince(*m_pendingSince));
+    m_pendingSince.reset();
+  }
+  if (resizing) {
+    ++m_blankFrames;
+  }
+}
+
+void ChartStress::Finish() {
+  // Give the resize timer time to settle and the last frame to be painted
+  m_finishing = true;
+  m_eventTimer.StartOnce(250);
+}
+
+void ChartStress::Report() const {
+  auto line = [](std::string_view name, const std::vector<double> &values) {
+    std::cout << std::format(
+        "{:<16} n={:<7} p50={:8.2f} p90={:8.2f} p99={:8.2f} max={:8.2f} ms\n",
+        name, values.size(), Percentile(values, 0.5), Percentile(values, 0.9),
+        Percentile(values, 0.99),
+        values.empty() ? 0.0 : std::ranges::max(values));
+  };
+
+  std::cout << std::format("events replayed  {}\n", m_events);
+  line("frame time", m_frameMs);
+  line("event latency", m_latencyMs);
+  std::cout << std::format("dropped frames   {}\n", m_droppedFrames);
+  std::cout << std::format("blank frames     {} (painted while resizing)\n",
+                           m_blankFrames);
+  const auto frames = m_view->GetFrameStatistics();
+  std::cout << std::format("coalesced        {} of {} view updates\n",
+                           frames.coalesced, frames.requests);
+  std::cout << std::format("peak rss         {:.1f} MiB\n",
+                           static_cast<double>(PeakRssBytes()) /
+                               (1024.0 * 1024.0));
+}
+
+std::pair<std::vector<double>, std::vector<double>>
+ChartStress::MakeSamples(size_t n) {
+  std::vector<double> xs(n);
+  std::vector<double> ys(n);
+  for (size_t i = 0; i < n; ++i, ++m_samples) {
+    xs[i] = 0.01 * static_cast<double>(m_samples);
+    ys[i] = (5 * std::sin(xs[i])) + 2.1;
+  }
+
+  return {std::move(xs), std::move(ys)};
+}
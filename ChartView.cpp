@@ -1,210 +1,303 @@
 #include "ChartView.h"
 #include "expected.hpp"
-#include "wx/affinematrix2d.h"
-#include "wx/dcbuffer.h"
+#include "wx/dcclient.h"
 #include "wx/event.h"
-#include "wx/geometry.h"
-#include "wx/graphics.h"
 #include <algorithm>
-#include <array>
-#include <format>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <utility>
 
 ChartView::ChartView(wxWindow *parent, wxWindowID id, const wxString &title)
-    : wxFrame(parent, id, title), m_margins(), m_points(0), m_xMinmax(0, 0),
-      m_yMinmax(0, 0), m_isResizing(false) {
+    : wxFrame(parent, id, title), m_isResizing(false) {
   SetBackgroundStyle(wxBG_STYLE_PAINT); // Needed for windows
 
-  // Set default margins
-  auto res = SetMargins({.left = 0.1, .top = 0.1, .right = 0.1, .bottom = 0.1});
-  assert(res && "Default margins are not in span!");
-
-  CalculateTransforms(); // Make first calc on start
-
   // Bindings
   this->Bind(wxEVT_PAINT, &ChartView::OnPaint, this);
   this->Bind(wxEVT_SIZE, &ChartView::OnResize, this);
+  this->Bind(wxEVT_MOUSEWHEEL, &ChartView::OnMouseWheel, this);
+  this->Bind(wxEVT_LEFT_DOWN, &ChartView::OnLeftDown, this);
+  this->Bind(wxEVT_LEFT_UP, &ChartView::OnLeftUp, this);
+  this->Bind(wxEVT_LEFT_DCLICK, &ChartView::OnLeftDClick, this);
+  this->Bind(wxEVT_MOTION, &ChartView::OnMotion, this);
+  this->Bind(wxEVT_MOUSE_CAPTURE_LOST, &ChartView::OnCaptureLost, this);
 
   m_timerResize.SetOwner(this);
   this->Bind(wxEVT_TIMER, &ChartView::OnResizeTimer, this,
              m_timerResize.GetId());
+  m_timerFrame.SetOwner(this);
+  this->Bind(wxEVT_TIMER, &ChartView::OnFrameTimer, this,
+             m_timerFrame.GetId());
 }
 
 tl::expected<void, std::string>
 ChartView::SetMargins(const chartview::margins &newMargins) {
-  constexpr float minVal = 0.0;
-  constexpr float maxVal = 0.5;
+  return m_renderer.SetMargins(newMargins);
+}
 
-  if (newMargins.left < minVal || newMargins.left > maxVal) {
-    return tl::make_unexpected(
-        std::format("left margin {} outside of span [{}, {}]", newMargins.left,
-                    minVal, maxVal));
+chartview::margins ChartView::GetMargins() const {
+  return m_renderer.GetMargins();
+}
+
+tl::expected<void, std::string>
+ChartView::SetPlotData(const std::vector<double> &xs,
+                       const std::vector<double> &ys) {
+  return m_renderer.SetPlotData(xs, ys);
+}
+
+tl::expected<void, std::string>
+ChartView::AppendPlotData(const std::vector<double> &xs,
+                          const std::vector<double> &ys) {
+  auto res = m_renderer.AppendPlotData(xs, ys);
+  if (res) {
+    ScheduleFrame();
   }
-  if (newMargins.top < minVal || newMargins.top > maxVal) {
-    return tl::make_unexpected(
-        std::format("top margin {} outside of span [{}, {}]", newMargins.top,
-                    minVal, maxVal));
+  return res;
+}
+
+tl::expected<void, std::string>
+ChartView::SetPlotData(const std::vector<std::int64_t> &timestamps,
+                       const std::vector<double> &ys) {
+  return m_renderer.SetPlotData(timestamps, ys);
+}
+
+tl::expected<void, std::string>
+ChartView::AppendPlotData(const std::vector<std::int64_t> &timestamps,
+                          const std::vector<double> &ys) {
+  auto res = m_renderer.AppendPlotData(timestamps, ys);
+  if (res) {
+    ScheduleFrame();
   }
-  if (newMargins.right < minVal || newMargins.right > maxVal) {
-    return tl::make_unexpected(
-        std::format("right margin {} outside of span [{}, {}]",
-                    newMargins.right, minVal, maxVal));
+  return res;
+}
+
+tl::expected<void, std::string>
+ChartView::PushPlotData(chartview::sampleblock block) {
+  auto res = m_renderer.PushPlotData(std::move(block));
+  if (!res) {
+    return tl::make_unexpected(std::move(res.error()));
   }
-  if (newMargins.bottom < minVal || newMargins.bottom > maxVal) {
-    return tl::make_unexpected(
-        std::format("bottom margin {} outside of span [{}, {}]",
-                    newMargins.bottom, minVal, maxVal));
+  if (*res) {
+    // Wakes the UI thread once per batch, later blocks ride along
+    CallAfter([this]() { ScheduleFrame(); });
   }
+  return {};
+}
 
-  m_margins = newMargins;
+tl::expected<size_t, std::string> ChartView::DrainPlotData() {
+  return m_renderer.DrainPlotData();
+}
 
-  return {};
+void ChartView::Clear() {
+  m_renderer.Clear();
 }
 
-chartview::margins ChartView::GetMargins() const {
-  return m_margins;
+void ChartView::SetPlotArchive(std::shared_ptr<TiledSeries> archive) {
+  m_renderer.SetPlotArchive(std::move(archive));
+  ScheduleFrame();
 }
 
 tl::expected<void, std::string>
-ChartView::SetPlotData(const std::vector<double> &xs,
-                       const std::vector<double> &ys) {
-  if (xs.size() != ys.size()) {
-    return tl::make_unexpected(std::format(
-        "plot error: x/y size mismatch x={}, y={}", xs.size(), ys.size()));
+ChartView::SetTimeWindow(std::optional<double> width) {
+  auto res = m_renderer.SetTimeWindow(width);
+  if (res) {
+    ScheduleFrame();
   }
+  return res;
+}
 
-  if (xs.size() == 0 || ys.size() == 0) {
-    return tl::make_unexpected("plot error: x/y size is 0. Use Clear instead");
-  }
+std::optional<double> ChartView::GetTimeWindow() const {
+  return m_renderer.GetTimeWindow();
+}
 
-  std::vector<chartview::point> tmp(xs.size());
-  for (size_t i = 0; i < xs.size(); ++i) {
-    tmp[i] = {.x = xs.at(i), .y = ys.at(i)};
+tl::expected<void, std::string>
+ChartView::SetPyramidSpill(std::optional<std::filesystem::path> directory,
+                           size_t residentNodes) {
+  auto res = m_renderer.SetPyramidSpill(std::move(directory), residentNodes);
+  if (res) {
+    ScheduleFrame();
   }
+  return res;
+}
 
-  std::pair<double, double> _xmax;
-  std::pair<double, double> _ymax;
-  try {
-    const auto [xmin, xmax] = std::ranges::minmax_element(xs);
-    const auto [ymin, ymax] = std::ranges::minmax_element(ys);
-
-    _xmax = {*xmin, *xmax};
-    _ymax = {*ymin, *ymax};
-  } catch (const std::exception &e) {
-    return tl::make_unexpected(
-        std::format("error getting minmax x and y: {}", e.what()));
-  }
+void ChartView::SetLineBackend(chartview::linebackend backend) {
+  m_renderer.SetLineBackend(backend);
+  ScheduleFrame();
+}
 
-  m_points = std::move(tmp);
-  m_xMinmax = std::move(_xmax);
-  m_yMinmax = std::move(_ymax);
+chartview::linebackend ChartView::GetLineBackend() const {
+  return m_renderer.GetLineBackend();
+}
 
-  return {};
+void ChartView::SetPlotStyle(chartview::plotstyle style) {
+  m_renderer.SetPlotStyle(style);
+  ScheduleFrame();
 }
 
-void ChartView::Clear() {
-  m_points.clear();
+chartview::plotstyle ChartView::GetPlotStyle() const {
+  return m_renderer.GetPlotStyle();
 }
 
-void ChartView::DrawPlot(wxAutoBufferedPaintDC &dc) {
-  dc.Clear();
-  std::unique_ptr<wxGraphicsContext> gc(wxGraphicsContext::Create(dc));
-  assert(gc && "failed to create Graphicscontext");
+void ChartView::SetDecimation(chartview::decimation strategy) {
+  m_renderer.SetDecimation(strategy);
+  ScheduleFrame();
+}
 
-  bool aaSupported = gc->SetAntialiasMode(wxAntialiasMode::wxANTIALIAS_DEFAULT);
+chartview::decimation ChartView::GetDecimation() const {
+  return m_renderer.GetDecimation();
+}
 
-  auto currentSize = this->GetSize();
-  wxRect2DDouble fullArea(0, 0, static_cast<double>(currentSize.GetWidth()),
-                          static_cast<double>(currentSize.GetHeight()));
-  wxRect2DDouble plotArea = fullArea;
-  // NOLINTBEGIN Ignore narrowing conversion warning
-  plotArea.Inset(fullArea.GetSize().GetWidth() * m_margins.left,
-                 fullArea.GetSize().GetHeight() * m_margins.top,
-                 fullArea.GetSize().GetWidth() * m_margins.right,
-                 fullArea.GetSize().GetHeight() * m_margins.bottom);
-  // NOLINTEND
+void ChartView::SetXAxisFormat(chartview::axisformat format) {
+  m_renderer.SetXAxisFormat(format);
+  ScheduleFrame();
+}
 
-  gc->SetBrush(*wxWHITE_BRUSH);
-  gc->SetPen(*wxBLACK_PEN);
-  gc->DrawRectangle(plotArea);
+chartview::axisformat ChartView::GetXAxisFormat() const {
+  return m_renderer.GetXAxisFormat();
+}
 
-  // Only draw graph when not resizing
-  if (m_isResizing) {
-    return;
+tl::expected<void, std::string>
+ChartView::SetViewport(const chartview::viewport &view) {
+  auto res = m_renderer.SetViewport(view);
+  if (res) {
+    ScheduleFrame();
   }
+  return res;
+}
+
+void ChartView::ResetViewport() {
+  m_renderer.ResetViewport();
+  ScheduleFrame();
+}
 
-  // Draw axis
-  auto [segs, newMin, newMax] = NiceLabels(m_yMinmax.first, m_yMinmax.second);
+chartview::viewport ChartView::GetViewport() const {
+  return m_renderer.GetViewport();
+}
 
-  if (segs > 1) {
-    gc->SetPen(*wxGREY_PEN);
-    for (size_t i = 0; i < segs; i++) {
+void ChartView::SetYAutoscale(bool enabled) {
+  m_renderer.SetYAutoscale(enabled);
+  ScheduleFrame();
+}
 
-      double y = plotArea.GetY() +
-                 (plotArea.GetHeight() * (1.0 - (double)i / (segs - 1)));
-      std::array<wxPoint2DDouble, 2> points{
-          wxPoint2DDouble(plotArea.GetX(), y),
-          wxPoint2DDouble(plotArea.GetRight(), y)};
-      gc->StrokeLines(points.size(), points.data());
-    }
-  } else {
-    newMin = m_yMinmax.first;
-    newMax = m_yMinmax.second;
-  }
+bool ChartView::GetYAutoscale() const {
+  return m_renderer.GetYAutoscale();
+}
 
-  // Transform points to plot area
-  wxAffineMatrix2D transformationMatrix;
-  transformationMatrix.Translate(plotArea.GetX(),
-                                 plotArea.GetY() + plotArea.GetHeight());
-  transformationMatrix.Scale(plotArea.GetWidth() /
-                                 (m_xMinmax.second - m_xMinmax.first),
-                             plotArea.GetHeight() / (newMax - newMin));
-  transformationMatrix.Scale(1, -1);
-  transformationMatrix.Translate(-m_xMinmax.first, -m_yMinmax.first);
+void ChartView::SetStatsOverlay(bool enabled) {
+  m_renderer.SetStatsOverlay(enabled);
+  ScheduleFrame();
+}
 
-  wxPen plotPen;
-  plotPen.SetColour(*wxBLUE);
+chartview::renderstatistics ChartView::GetRenderStatistics() const {
+  return m_renderer.GetRenderStats().GetStatistics();
+}
 
-  gc->SetPen(plotPen);
-  gc->SetBrush(wxNullBrush);
+tl::expected<void, std::string> ChartView::SetMaxFrameRate(double fps) {
+  return m_scheduler.SetMaxFps(fps);
+}
 
-  auto path = gc->CreatePath();
-  for (auto &point : m_points) {
-    double x = point.x;
-    double y = point.y;
-    transformationMatrix.TransformPoint(&x, &y);
-    path.AddLineToPoint(x, y);
+double ChartView::GetMaxFrameRate() const {
+  return m_scheduler.GetMaxFps();
+}
+
+chartview::framestatistics ChartView::GetFrameStatistics() const {
+  return m_scheduler.GetStatistics();
+}
+
+void ChartView::Render(wxDC &dc) {
+  const wxSize size = GetClientSize();
+  if (size.GetWidth() <= 0 || size.GetHeight() <= 0) {
+    return;
   }
 
-  gc->DrawPath(path);
+  // Blocks that do not fit the series are dropped here, call DrainPlotData
+  // directly to see why
+  static_cast<void>(m_renderer.DrainPlotData());
+
+  auto &stats = m_renderer.GetRenderStats();
+  {
+    ScopedStageTimer frameTimer(stats, chartview::renderstage::frame);
+    auto &gc = BackBuffer(size);
+
+    // The state stack keeps clips and transforms of one frame out of the
+    // next, the context outlives it
+    gc.PushState();
+    gc.SetPen(wxNullPen);
+    gc.SetBrush(m_backgroundBrush);
+    gc.DrawRectangle(0, 0, size.GetWidth(), size.GetHeight());
+    // Only draw graph when not resizing
+    m_renderer.DrawPlot(gc, size, !m_isResizing);
+    gc.PopState();
+    gc.Flush();
+  }
+
+  {
+    ScopedStageTimer blitTimer(stats, chartview::renderstage::blit);
+    dc.Blit(0, 0, size.GetWidth(), size.GetHeight(), &m_backBufferDC, 0, 0);
+  }
+  m_scheduler.FramePainted(FrameScheduler::clock::now());
+  if (m_renderer.IsAwaitingChunks()) {
+    // Chunks are read in the background, look again when they may be in
+    ScheduleFrame();
+  }
+}
+
+bool ChartView::IsResizing() const {
+  return m_isResizing;
+}
+
+tl::expected<wxImage, std::string> ChartView::RenderToImage(int width,
+                                                            int height) const {
+  return m_renderer.RenderToImage(width, height);
 }
 
-std::tuple<int, double, double> ChartView::NiceLabels(double origLow,
-                                                      double origHigh) {
-  constexpr std::array<double, 7> rangeMults{0.2, 0.25, 0.5, 1.0,
-                                             2.0, 2.5,  5.0};
-  constexpr int maxSegments = 6;
+wxGraphicsContext &ChartView::BackBuffer(const wxSize &size) {
+  if (m_backBufferGC && m_backBuffer.GetSize() == size) {
+    return *m_backBufferGC;
+  }
+
+  ScopedStageTimer timer(m_renderer.GetRenderStats(),
+                         chartview::renderstage::gcCreate);
 
-  double magnitude = std::floor(std::log10(origHigh - origLow));
+  // The context has to go before the bitmap it draws into
+  m_backBufferGC.reset();
+  m_backBufferDC.SelectObject(wxNullBitmap);
+  m_backBuffer = wxBitmap(size, 24);
+  m_backBufferDC.SelectObject(m_backBuffer);
 
-  for (auto r : rangeMults) {
-    double stepSize = r * std::pow(10.0, magnitude);
-    double low = std::floor(origLow / stepSize) * stepSize;
-    double high = std::ceil(origHigh / stepSize) * stepSize;
+  m_backBufferGC.reset(wxGraphicsContext::Create(m_backBufferDC));
+  assert(m_backBufferGC && "failed to create Graphicscontext");
+  m_backBufferGC->SetAntialiasMode(wxAntialiasMode::wxANTIALIAS_DEFAULT);
+  m_backgroundBrush = wxBrush(GetBackgroundColour());
 
-    auto segments = static_cast<int>(round((high - low) / stepSize));
+  return *m_backBufferGC;
+}
 
-    if (segments <= maxSegments) {
-      return std::make_tuple(segments, low, high);
-    }
+void ChartView::ScheduleFrame() {
+  const auto delay = m_scheduler.Request(FrameScheduler::clock::now());
+  if (!delay) {
+    return;
+  }
+  if (*delay == FrameScheduler::clock::duration::zero()) {
+    Refresh();
+    return;
   }
 
-  // return some defaults in case rangeMults and maxSegments are mismatched
-  return std::make_tuple(10, origLow, origHigh);
+  const auto ms = std::chrono::ceil<std::chrono::milliseconds>(*delay);
+  m_timerFrame.StartOnce(static_cast<int>(std::max<long long>(ms.count(), 1)));
+}
+
+void ChartView::OnFrameTimer(wxTimerEvent & /*evt*/) {
+  // A paint in the meantime, e.g. after an expose, already showed it
+  if (m_scheduler.IsPending()) {
+    Refresh();
+  }
 }
 
 void ChartView::OnResizeTimer(wxTimerEvent & /*evt*/) {
   m_isResizing = false;
-  Refresh();
+  ScheduleFrame();
 }
 
 void ChartView::OnResize(wxSizeEvent &evt) {
@@ -215,8 +308,57 @@ void ChartView::OnResize(wxSizeEvent &evt) {
 }
 
 void ChartView::OnPaint(wxPaintEvent &evt) {
-  wxAutoBufferedPaintDC dc(this);
-  DrawPlot(dc);
+  // Render draws into the back buffer, no paint DC buffering is needed
+  wxPaintDC dc(this);
+  Render(dc);
 
   evt.Skip();
 }
+
+void ChartView::OnMouseWheel(wxMouseEvent &evt) {
+  constexpr double zoomPerNotch = 0.8;
+
+  const double notches = static_cast<double>(evt.GetWheelRotation()) /
+                         static_cast<double>(evt.GetWheelDelta());
+  const wxPoint pos = evt.GetPosition();
+  m_renderer.Zoom(GetClientSize(), wxPoint2DDouble(pos.x, pos.y),
+                  std::pow(zoomPerNotch, notches));
+  ScheduleFrame();
+}
+
+void ChartView::OnLeftDown(wxMouseEvent &evt) {
+  m_dragLast = evt.GetPosition();
+  CaptureMouse();
+
+  evt.Skip();
+}
+
+void ChartView::OnLeftUp(wxMouseEvent &evt) {
+  m_dragLast.reset();
+  if (HasCapture()) {
+    ReleaseMouse();
+  }
+
+  evt.Skip();
+}
+
+void ChartView::OnLeftDClick(wxMouseEvent & /*evt*/) {
+  ResetViewport();
+}
+
+void ChartView::OnMotion(wxMouseEvent &evt) {
+  if (!m_dragLast || !evt.LeftIsDown()) {
+    evt.Skip();
+    return;
+  }
+
+  const wxPoint pos = evt.GetPosition();
+  m_renderer.Pan(GetClientSize(), pos.x - m_dragLast->x,
+                 pos.y - m_dragLast->y);
+  m_dragLast = pos;
+  ScheduleFrame();
+}
+
+void ChartView::OnCaptureLost(wxMouseCaptureLostEvent & /*evt*/) {
+  m_dragLast.reset();
+}
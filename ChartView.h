@@ -2,25 +2,18 @@
 
 #include <wx/wx.h>
 
+#include "ChartRenderer.h"
+#include "FrameScheduler.h"
 #include "expected.hpp"
-#include "wx/affinematrix2d.h"
-#include "wx/dcbuffer.h"
+#include "wx/dcmemory.h"
 #include "wx/event.h"
+#include "wx/graphics.h"
 #include "wx/timer.h"
 
-namespace chartview {
-struct margins {
-  float left;
-  float top;
-  float right;
-  float bottom;
-};
-
-struct point {
-  double x;
-  double y;
-};
-} // namespace chartview
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
 
 class ChartView : public wxFrame {
 public:
@@ -34,25 +27,104 @@ public:
 
   tl::expected<void, std::string> SetPlotData(const std::vector<double> &xs,
                                               const std::vector<double> &ys);
+  tl::expected<void, std::string>
+  AppendPlotData(const std::vector<double> &xs, const std::vector<double> &ys);
+  // Nanosecond timestamps since the epoch, see ChartRenderer::SetPlotData
+  tl::expected<void, std::string>
+  SetPlotData(const std::vector<std::int64_t> &timestamps,
+              const std::vector<double> &ys);
+  tl::expected<void, std::string>
+  AppendPlotData(const std::vector<std::int64_t> &timestamps,
+                 const std::vector<double> &ys);
+  // Safe from any thread, see ChartRenderer::PushPlotData. Queued blocks
+  // are appended right before the next frame, the first block after a
+  // frame schedules one.
+  tl::expected<void, std::string> PushPlotData(chartview::sampleblock block);
+  // Append the queued blocks now instead of at the next frame, reports
+  // blocks that could not be appended
+  tl::expected<size_t, std::string> DrainPlotData();
   void Clear();
+  // See ChartRenderer::SetPlotArchive
+  void SetPlotArchive(std::shared_ptr<TiledSeries> archive);
+
+  // Show only the last width of x, see ChartRenderer::SetTimeWindow
+  tl::expected<void, std::string> SetTimeWindow(std::optional<double> width);
+  [[nodiscard]] std::optional<double> GetTimeWindow() const;
+  // See ChartRenderer::SetPyramidSpill
+  tl::expected<void, std::string>
+  SetPyramidSpill(std::optional<std::filesystem::path> directory,
+                  size_t residentNodes = 4096);
+
+  void SetLineBackend(chartview::linebackend backend);
+  [[nodiscard]] chartview::linebackend GetLineBackend() const;
+  void SetPlotStyle(chartview::plotstyle style);
+  [[nodiscard]] chartview::plotstyle GetPlotStyle() const;
+  void SetDecimation(chartview::decimation strategy);
+  [[nodiscard]] chartview::decimation GetDecimation() const;
+
+  void SetXAxisFormat(chartview::axisformat format);
+  [[nodiscard]] chartview::axisformat GetXAxisFormat() const;
+
+  // Visible data range. Mouse wheel zooms around the cursor, dragging with
+  // the left button pans and a double click resets to showing all data.
+  tl::expected<void, std::string> SetViewport(const chartview::viewport &view);
+  void ResetViewport();
+  [[nodiscard]] chartview::viewport GetViewport() const;
+  // Fit y to the visible data while zoomed, on by default
+  void SetYAutoscale(bool enabled);
+  [[nodiscard]] bool GetYAutoscale() const;
+
+  void SetStatsOverlay(bool enabled);
+  [[nodiscard]] chartview::renderstatistics GetRenderStatistics() const;
+
+  // Updates and view changes are coalesced and painted at most fps times a
+  // second, 60 by default
+  tl::expected<void, std::string> SetMaxFrameRate(double fps);
+  [[nodiscard]] double GetMaxFrameRate() const;
+  [[nodiscard]] chartview::framestatistics GetFrameStatistics() const;
+
+  // Paint the view as OnPaint would, at the current client size. Lets
+  // headless tools drive the paint path of a hidden view.
+  void Render(wxDC &dc);
+  [[nodiscard]] bool IsResizing() const;
+
+  // Render the current plot offscreen, independent of the window size
+  [[nodiscard]] tl::expected<wxImage, std::string>
+  RenderToImage(int width, int height) const;
 
 private:
-  chartview::margins m_margins;
+  ChartRenderer m_renderer;
+
+  // Back buffer at the client size with a graphics context bound to it.
+  // Paints reuse both and only a resize recreates them.
+  wxBitmap m_backBuffer;
+  wxMemoryDC m_backBufferDC;
+  std::unique_ptr<wxGraphicsContext> m_backBufferGC;
+  wxBrush m_backgroundBrush;
 
-  std::vector<chartview::point> m_points;
-  std::pair<double, double> m_xMinmax;
-  std::pair<double, double> m_yMinmax;
   bool m_isResizing;
   wxTimer m_timerResize;
 
-  wxAffineMatrix2D m_pointsToPlotarea;
+  std::optional<wxPoint> m_dragLast;
+
+  FrameScheduler m_scheduler;
+  wxTimer m_timerFrame;
 
-  void DrawPlot(wxAutoBufferedPaintDC &dc);
+  // Context of the back buffer, recreated when size differs from the
+  // buffer's size
+  wxGraphicsContext &BackBuffer(const wxSize &size);
 
-  static std::tuple<int, double, double> NiceLabels(double origLow,
-                                                    double origHigh);
+  // Invalidate the view, painted by the scheduler's next frame
+  void ScheduleFrame();
 
   void OnPaint(wxPaintEvent &evt);
+  void OnFrameTimer(wxTimerEvent &evt);
   void OnResize(wxSizeEvent &evt);
   void OnResizeTimer(wxTimerEvent &evt);
+  void OnMouseWheel(wxMouseEvent &evt);
+  void OnLeftDown(wxMouseEvent &evt);
+  void OnLeftUp(wxMouseEvent &evt);
+  void OnLeftDClick(wxMouseEvent &evt);
+  void OnMotion(wxMouseEvent &evt);
+  void OnCaptureLost(wxMouseCaptureLostEvent &evt);
 };
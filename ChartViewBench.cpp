@@ -0,0 +1,578 @@
+#include <wx/wx.h>
+
+#include "ChartRenderer.h"
+#include "Decimation.h"
+#include "DecimationCache.h"
+#include "FrameArena.h"
+#include "LodPyramid.h"
+#include "PanPrefetcher.h"
+#include "Rasterizer.h"
+#include "StreamingLttb.h"
+#include "wx/dcmemory.h"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmarks the ChartView drawing pipeline stage by stage, across series
+// sizes and shapes. Results are written in the Google Benchmark JSON layout
+// so existing tooling can track them over time.
+//
+// usage: ChartViewBench [--benchmark_filter=<substring>]
+//                       [--benchmark_out=<file.json>]
+//                       [--benchmark_min_time=<seconds>]
+//                       [--max_points=<n>]
+class ChartViewBench : public wxApp {
+  bool OnInit() override;
+  int OnRun() override;
+
+  std::string m_filter;
+  std::string m_outPath;
+  double m_minTime = 0.2;
+  size_t m_maxPoints = 100'000'000;
+};
+
+// NOLINTNEXTLINE
+wxIMPLEMENT_APP_CONSOLE(ChartViewBench);
+
+namespace {
+struct benchresult {
+  std::string name;
+  size_t iterations;
+  double realTimeNs;
+  double cpuTimeNs;
+  double itemsPerSecond;
+  // Extra values reported next to the timings, like Google Benchmark's
+  // user counters
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+enum class shape : std::uint8_t { sine, noise, step, spikes };
+
+constexpr std::array<shape, 4> shapes{shape::sine, shape::noise, shape::step,
+                                      shape::spikes};
+constexpr std::array<size_t, 6> sizes{1'000,     10'000,     100'000,
+                                      1'000'000, 10'000'000, 100'000'000};
+constexpr int imageWidth = 800;
+constexpr int imageHeight = 600;
+
+// Keeps the compiler from discarding a computed value
+template <typename T> void DoNotOptimize(T value) {
+  [[maybe_unused]] static volatile T sink{};
+  sink = value;
+}
+
+std::string_view ShapeName(shape s) {
+  switch (s) {
+  case shape::sine:
+    return "sine";
+  case shape::noise:
+    return "noise";
+  case shape::step:
+    return "step";
+  case shape::spikes:
+    return "spikes";
+  }
+  return "unknown";
+}
+
+void MakeSeries(shape s, size_t n, std::vector<double> &xs,
+                std::vector<double> &ys) {
+  xs.resize(n);
+  ys.resize(n);
+
+  std::mt19937_64 rng(42);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::uniform_real_distribution<double> spike(5.0, 10.0);
+  const size_t stepLength = std::max<size_t>(n / 10, 1);
+
+  for (size_t i = 0; i < n; i++) {
+    // Same x spacing and sine as ChartApp::OnInit
+    xs[i] = 0.01 * static_cast<double>(i);
+    switch (s) {
+    case shape::sine:
+      ys[i] = (5 * std::sin(xs[i])) + 2.1;
+      break;
+    case shape::noise:
+      ys[i] = noise(rng);
+      break;
+    case shape::step:
+      ys[i] = static_cast<double>(i / stepLength);
+      break;
+    case shape::spikes:
+      ys[i] = i % 1000 == 0 ? spike(rng) : 0.0;
+      break;
+    }
+  }
+}
+
+// Pixels covered by the aliased polyline through points, one byte per pixel
+// of the benchmark image, drawn the way the raster backend draws
+std::vector<unsigned char>
+PolylineMask(std::span<const chartview::point> points,
+             const wxAffineMatrix2D &transform) {
+  std::vector<unsigned char> rgb(
+      static_cast<size_t>(imageWidth) * imageHeight * 3, 255);
+  Rasterizer raster(rgb.data(), imageWidth, imageHeight);
+
+  // Transformed on the fly, the full series may not fit in memory twice
+  double px = 0;
+  double py = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    double x = points[i].x;
+    double y = points[i].y;
+    transform.TransformPoint(&x, &y);
+    if (i > 0) {
+      raster.DrawLine(px, py, x, y, {.r = 0, .g = 0, .b = 0});
+    }
+    px = x;
+    py = y;
+  }
+
+  std::vector<unsigned char> mask(static_cast<size_t>(imageWidth) *
+                                  imageHeight);
+  for (size_t i = 0; i < mask.size(); ++i) {
+    mask[i] = rgb[i * 3] == 0 ? 1 : 0;
+  }
+  return mask;
+}
+
+// Pixels that differ from the full resolution polyline, relative to the
+// pixels the full resolution polyline covers
+double VisualError(const std::vector<unsigned char> &reference,
+                   const std::vector<unsigned char> &candidate) {
+  size_t covered = 0;
+  size_t differing = 0;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    covered += reference[i];
+    differing += reference[i] != candidate[i] ? 1 : 0;
+  }
+  return covered > 0 ? static_cast<double>(differing) / covered : 0.0;
+}
+
+// Runs fn until minTime has passed, at least once
+benchresult Run(const std::string &name, size_t items, double minTime,
+                const std::function<void()> &fn) {
+  using clock = std::chrono::steady_clock;
+
+  size_t iterations = 0;
+  const std::clock_t cpuStart = std::clock();
+  const auto start = clock::now();
+  auto elapsed = clock::duration::zero();
+  do {
+    fn();
+    ++iterations;
+    elapsed = clock::now() - start;
+  } while (std::chrono::duration<double>(elapsed).count() < minTime);
+  const std::clock_t cpuEnd = std::clock();
+
+  const double realNs =
+      std::chrono::duration<double, std::nano>(elapsed).count() /
+      static_cast<double>(iterations);
+  const double cpuNs = (static_cast<double>(cpuEnd - cpuStart) * 1e9 /
+                        CLOCKS_PER_SEC) /
+                       static_cast<double>(iterations);
+
+  return {.name = name,
+          .iterations = iterations,
+          .realTimeNs = realNs,
+          .cpuTimeNs = cpuNs,
+          .itemsPerSecond = static_cast<double>(items) / (realNs * 1e-9),
+          .counters = {}};
+}
+
+std::string ToJson(const std::vector<benchresult> &results) {
+  const auto now = std::chrono::system_clock::now();
+
+  std::string json = "{\n  \"context\": {\n";
+  json += std::format("    \"date\": \"{:%FT%T%z}\",\n",
+                      std::chrono::floor<std::chrono::seconds>(now));
+  json += std::format("    \"num_cpus\": {},\n",
+                      std::thread::hardware_concurrency());
+#ifdef NDEBUG
+  json += "    \"library_build_type\": \"release\"\n";
+#else
+  json += "    \"library_build_type\": \"debug\"\n";
+#endif
+  json += "  },\n  \"benchmarks\": [\n";
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto &r = results[i];
+    json += std::format("    {{\n"
+                        "      \"name\": \"{}\",\n"
+                        "      \"run_type\": \"iteration\",\n"
+                        "      \"iterations\": {},\n"
+                        "      \"real_time\": {:.3f},\n"
+                        "      \"cpu_time\": {:.3f},\n"
+                        "      \"time_unit\": \"ns\",\n"
+                        "      \"items_per_second\": {:.3f}",
+                        r.name, r.iterations, r.realTimeNs, r.cpuTimeNs,
+                        r.itemsPerSecond);
+    for (const auto &[counter, value] : r.counters) {
+      json += std::format(",\n      \"{}\": {:.6f}", counter, value);
+    }
+    json += std::format("\n    }}{}\n", i + 1 < results.size() ? "," : "");
+  }
+  json += "  ]\n}\n";
+
+  return json;
+}
+} // namespace
+
+bool ChartViewBench::OnInit() {
+  // wxApp::OnInit is not called, its command line parser would reject the
+  // benchmark options
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = wxString(argv[i]).ToStdString();
+    auto value = [&](std::string_view option) {
+      using result_t = std::optional<std::string>;
+      if (arg.starts_with(option)) {
+        return result_t(arg.substr(option.size()));
+      }
+      return result_t();
+    };
+
+    try {
+      if (auto filter = value("--benchmark_filter=")) {
+        m_filter = *filter;
+      } else if (auto out = value("--benchmark_out=")) {
+        m_outPath = *out;
+      } else if (auto minTime = value("--benchmark_min_time=")) {
+        m_minTime = std::stod(*minTime);
+      } else if (auto maxPoints = value("--max_points=")) {
+        m_maxPoints = std::stoull(*maxPoints);
+      } else {
+        std::cerr << std::format("unknown option {}\n", arg);
+        return false;
+      }
+    } catch (const std::exception &e) {
+      std::cerr << std::format("invalid option {}: {}\n", arg, e.what());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int ChartViewBench::OnRun() {
+  std::vector<benchresult> results;
+  // Returns the result to attach counters to, nullptr when filtered out.
+  // Only valid until the next benchmark runs.
+  auto selected = [&](const std::string &name) {
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+  };
+  auto bench = [&](const std::string &name, size_t items,
+                   const std::function<void()> &fn) -> benchresult * {
+    if (!selected(name)) {
+      return nullptr;
+    }
+    results.push_back(Run(name, items, m_minTime, fn));
+    const auto &r = results.back();
+    std::cout << std::format("{:<40} {:>14.0f} ns {:>10} iters {:>14.0f} "
+                             "items/s\n",
+                             r.name, r.realTimeNs, r.iterations,
+                             r.itemsPerSecond);
+    return &results.back();
+  };
+  auto addCounter = [](benchresult *r, const std::string &name,
+                       double value) {
+    if (r != nullptr) {
+      r->counters.emplace_back(name, value);
+      std::cout << std::format("{:<40} {:>14.6f} {}\n", "", value, name);
+    }
+  };
+
+  wxBitmap bitmap(imageWidth, imageHeight, 24);
+  wxMemoryDC dc(bitmap);
+  dc.SetBackground(*wxWHITE_BRUSH);
+  std::unique_ptr<wxGraphicsContext> gc(wxGraphicsContext::Create(dc));
+  const wxSize imageSize(imageWidth, imageHeight);
+
+  std::vector<double> xs;
+  std::vector<double> ys;
+  for (const auto s : shapes) {
+    for (const auto n : sizes) {
+      if (n > m_maxPoints) {
+        continue;
+      }
+      const auto suffix = std::format("{}/{}", ShapeName(s), n);
+
+      MakeSeries(s, n, xs, ys);
+
+      ChartRenderer renderer;
+      auto res = renderer.SetPlotData(xs, ys);
+      if (!res) {
+        std::cerr << std::format("{}: {}\n", suffix, res.error());
+        return 1;
+      }
+
+      bench(std::format("BM_SetPlotData/{}", suffix), n, [&]() {
+        ChartRenderer tmp;
+        DoNotOptimize(tmp.SetPlotData(xs, ys).has_value());
+      });
+
+      // Same series fed as producer blocks through the ingestion queue,
+      // drained every few blocks as frames would rather than queueing a
+      // second copy of the series
+      bench(std::format("BM_PushDrain/{}", suffix), n, [&]() {
+        constexpr size_t blockSize = 1024;
+        constexpr size_t blocksPerDrain = 64;
+        ChartRenderer tmp;
+        size_t appended = 0;
+        for (size_t i = 0; i < n; i += blockSize) {
+          const auto from = static_cast<std::ptrdiff_t>(i);
+          const auto to =
+              static_cast<std::ptrdiff_t>(std::min(n, i + blockSize));
+          static_cast<void>(tmp.PushPlotData(
+              {.xs = std::vector<double>(xs.begin() + from, xs.begin() + to),
+               .ys = std::vector<double>(ys.begin() + from, ys.begin() + to)}));
+          if ((i / blockSize) % blocksPerDrain == blocksPerDrain - 1) {
+            appended += tmp.DrainPlotData().value_or(0);
+          }
+        }
+        DoNotOptimize(appended + tmp.DrainPlotData().value_or(0));
+      });
+
+      bench(std::format("BM_Extent/{}", suffix), n, [&]() {
+        DoNotOptimize(ChartRenderer::Extent(ys).second);
+      });
+
+      const auto [ymin, ymax] = ChartRenderer::Extent(ys);
+      bench(std::format("BM_NiceLabels/{}", suffix), 1, [&]() {
+        DoNotOptimize(std::get<0>(ChartRenderer::NiceLabels(ymin, ymax)));
+      });
+
+      // The renderer's own points, not another copy of the series
+      const auto series = renderer.GetSeries();
+      const std::span<const chartview::point> points = series->points;
+      const auto plotArea = renderer.PlotArea(imageSize);
+      const auto columns = static_cast<int>(plotArea.GetWidth());
+
+      const auto transform =
+          ChartRenderer::PointsToPlotArea(plotArea, renderer.GetViewport());
+
+      // Visual error of the downsamplers against the full series, the
+      // reference is only drawn when a benchmark reports it
+      std::optional<std::vector<unsigned char>> reference;
+      auto visualError = [&](std::span<const chartview::point> reduced) {
+        if (!reference) {
+          reference = PolylineMask(points, transform);
+        }
+        return VisualError(*reference, PolylineMask(reduced, transform));
+      };
+
+      auto *minmax = bench(std::format("BM_Decimate/{}", suffix), n, [&]() {
+        DoNotOptimize(
+            chartview::DecimateMinMax(points, xs.front(), xs.back(), columns)
+                .size());
+      });
+
+      // Same reduction with the buffers drawn from a rewound frame arena,
+      // as ChartRenderer does per frame
+      FrameArena arena;
+      auto *arenaBench =
+          bench(std::format("BM_DecimateArena/{}", suffix), n, [&]() {
+            arena.Reset();
+            DoNotOptimize(chartview::DecimateMinMax(points, xs.front(),
+                                                    xs.back(), columns, &arena)
+                              .size());
+          });
+      // The block a frame settles on, grown once on the first frames
+      addCounter(arenaBench, "arena_bytes",
+                 static_cast<double>(arena.GetCapacity()));
+      addCounter(arenaBench, "heap_allocations",
+                 static_cast<double>(arena.GetAllocationCount()));
+
+      const auto decimated =
+          chartview::DecimateMinMax(points, xs.front(), xs.back(), columns);
+      addCounter(minmax, "visual_error", visualError(decimated));
+      addCounter(minmax, "points_out", static_cast<double>(decimated.size()));
+
+      // Same two points per column as the renderer's lttb strategy
+      const size_t threshold = 2 * static_cast<size_t>(columns);
+      auto *lttb = bench(std::format("BM_Lttb/{}", suffix), n, [&]() {
+        DoNotOptimize(chartview::DecimateLttb(points, threshold).size());
+      });
+      if (lttb != nullptr) {
+        const auto sampled = chartview::DecimateLttb(points, threshold);
+        addCounter(lttb, "visual_error", visualError(sampled));
+        addCounter(lttb, "points_out", static_cast<double>(sampled.size()));
+      }
+
+      // One live frame: a block is appended and the cached columns of the
+      // scrolling view catch up with it, at the same cost for any n. The
+      // window evicts as many points as are appended, so the series stays
+      // at n points however many iterations run. The live copy is only made
+      // when the benchmark runs and freed right after it.
+      const double span = xs.back() - xs.front();
+      if (const auto name = std::format("BM_DecimateAppend/{}", suffix);
+          selected(name)) {
+        constexpr size_t block = 64;
+        ChartRenderer live;
+        static_cast<void>(live.SetTimeWindow(span));
+        static_cast<void>(live.SetPlotData(xs, ys));
+        DecimationCache cache;
+        const double step = span / static_cast<double>(n);
+        double next = xs.back();
+        std::vector<double> blockXs(block);
+        const std::vector<double> blockYs(ys.begin(), ys.begin() + block);
+        auto *append = bench(name, block, [&]() {
+          for (auto &x : blockXs) {
+            x = next += step;
+          }
+          static_cast<void>(live.AppendPlotData(blockXs, blockYs));
+          const auto data = live.GetSeries();
+          const double xHigh = data->xMinmax.second;
+          const auto [first, last] = live.VisibleRange(xHigh - span, xHigh);
+          if (cache.Update(*data, first, last, xHigh - span, xHigh,
+                           columns)) {
+            DoNotOptimize(cache.Columns().size());
+          }
+        });
+        // Points the last frame reduced, the rest came from the cache
+        addCounter(append, "points_reduced",
+                   static_cast<double>(cache.GetReducedCount()));
+      }
+
+      // The same live frame with the lttb strategy, the picks follow the
+      // appended block instead of the whole view being picked again
+      if (const auto name = std::format("BM_LttbAppend/{}", suffix);
+          selected(name)) {
+        constexpr size_t block = 64;
+        ChartRenderer live;
+        static_cast<void>(live.SetTimeWindow(span));
+        static_cast<void>(live.SetPlotData(xs, ys));
+        StreamingLttb picks;
+        const double step = span / static_cast<double>(n);
+        double next = xs.back();
+        std::vector<double> blockXs(block);
+        const std::vector<double> blockYs(ys.begin(), ys.begin() + block);
+        auto *append = bench(name, block, [&]() {
+          for (auto &x : blockXs) {
+            x = next += step;
+          }
+          static_cast<void>(live.AppendPlotData(blockXs, blockYs));
+          const auto data = live.GetSeries();
+          const double xHigh = data->xMinmax.second;
+          const auto [first, last] = live.VisibleRange(xHigh - span, xHigh);
+          if (picks.Update(*data, first, last, xHigh - span, xHigh,
+                           columns)) {
+            DoNotOptimize(picks.Points().size());
+          }
+        });
+        addCounter(append, "points_reduced",
+                   static_cast<double>(picks.GetReducedCount()));
+      }
+
+      // One frame of a steady pan across a tenth of the series: the columns
+      // scrolled in were mostly reduced ahead by the prefetcher, the frame
+      // splices them in. Frames are timed as 16 ms apart.
+      DecimationCache panCache;
+      PanPrefetcher prefetcher;
+      const double width = span / 10;
+      const double panStep = width / 32;
+      double xLow = xs.front();
+      auto now = PanPrefetcher::clock::now();
+      auto *pan =
+          bench(std::format("BM_DecimatePan/{}", suffix), n / 320, [&]() {
+            if (xLow + panStep + width > xs.back()) {
+              xLow = xs.front();
+            }
+            xLow += panStep;
+            now += std::chrono::milliseconds(16);
+            prefetcher.Pan(panStep, now);
+            if (auto strip = prefetcher.Take()) {
+              panCache.Splice(std::move(*strip));
+            }
+            const chartview::viewport view{
+                .xLow = xLow, .xHigh = xLow + width, .yLow = 0, .yHigh = 1};
+            const auto [first, last] =
+                renderer.VisibleRange(view.xLow, view.xHigh);
+            if (panCache.Update(*series, first, last, view.xLow, view.xHigh,
+                                columns)) {
+              DoNotOptimize(panCache.Columns().size());
+            }
+            prefetcher.Speculate(series, view, columns, panCache, now);
+          });
+      addCounter(pan, "points_reduced",
+                 static_cast<double>(panCache.GetReducedCount()));
+
+      // Zoomed out view of the whole series from the pyramid, the same
+      // columns as BM_Decimate without touching the points
+      LodPyramid pyramid;
+      pyramid.Append(points);
+      auto *lod = bench(std::format("BM_LodEnvelope/{}", suffix), n, [&]() {
+        DoNotOptimize(
+            pyramid.Envelope(xs.front(), xs.back(), columns).size());
+      });
+      addCounter(lod, "nodes_resident",
+                 static_cast<double>(pyramid.GetResidentCount()));
+
+      // Same with all but the newest nodes of each level spilled to disk,
+      // the coarse levels the view is read from are mostly on disk then
+      LodPyramid spilled;
+      const auto spillDirectory = std::filesystem::temp_directory_path();
+      if (auto res = spilled.SetSpill(spillDirectory, 64); !res) {
+        std::cerr << std::format("{}: {}\n", suffix, res.error());
+        return 1;
+      }
+      spilled.Append(points);
+      auto *spill =
+          bench(std::format("BM_LodEnvelopeSpill/{}", suffix), n, [&]() {
+            DoNotOptimize(
+                spilled.Envelope(xs.front(), xs.back(), columns).size());
+          });
+      addCounter(spill, "nodes_resident",
+                 static_cast<double>(spilled.GetResidentCount()));
+      addCounter(spill, "nodes_spilled",
+                 static_cast<double>(spilled.GetSpilledCount()));
+
+      auto transformed = decimated;
+      bench(std::format("BM_Transform/{}", suffix), decimated.size(), [&]() {
+        for (size_t i = 0; i < decimated.size(); ++i) {
+          transformed[i] = decimated[i];
+          transform.TransformPoint(&transformed[i].x, &transformed[i].y);
+        }
+      });
+
+      bench(std::format("BM_PathBuild/{}", suffix), transformed.size(), [&]() {
+        auto path = gc->CreatePath();
+        for (const auto &point : transformed) {
+          path.AddLineToPoint(point.x, point.y);
+        }
+      });
+
+      bench(std::format("BM_DrawPlot/{}", suffix), n,
+            [&]() { renderer.DrawPlot(dc, imageSize); });
+
+      renderer.SetLineBackend(chartview::linebackend::raster);
+      bench(std::format("BM_DrawPlotRaster/{}", suffix), n,
+            [&]() { renderer.DrawPlot(dc, imageSize); });
+    }
+  }
+
+  gc.reset();
+  dc.SelectObject(wxNullBitmap);
+
+  if (!m_outPath.empty()) {
+    std::ofstream out(m_outPath);
+    out << ToJson(results);
+    if (!out) {
+      std::cerr << std::format("failed to write {}\n", m_outPath);
+      return 1;
+    }
+  }
+
+  return 0;
+}
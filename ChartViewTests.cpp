@@ -0,0 +1,89 @@
+#include "ChartViewTests.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+// Property checks of the drawing pipeline, see ChartViewTests.h. Prints the
+// failed checks and exits with 1 if there are any.
+//
+// usage: ChartViewTests [<seed>]
+
+namespace {
+int failures = 0;
+} // namespace
+
+void Fail(const std::string &what) {
+  ++failures;
+  std::cerr << "failed: " << what << '\n';
+}
+
+double RandomY(std::mt19937 &rng) {
+  return std::round(std::uniform_real_distribution<double>(-1, 1)(rng) * 64) /
+         64;
+}
+
+std::pair<double, double> BruteExtent(std::span<const chartview::point> points,
+                                      size_t first, size_t last) {
+  std::pair extent{std::numeric_limits<double>::infinity(),
+                   -std::numeric_limits<double>::infinity()};
+  for (size_t i = first; i < last; ++i) {
+    extent.first = std::min(extent.first, points[i].y);
+    extent.second = std::max(extent.second, points[i].y);
+  }
+  return extent;
+}
+
+bool SameColumns(std::span<const chartview::bucket> a,
+                 std::span<const chartview::bucket> b) {
+  return std::ranges::equal(a, b, [](const auto &l, const auto &r) {
+    return l.column == r.column && l.first == r.first && l.min == r.min &&
+           l.max == r.max && l.last == r.last &&
+           std::abs(l.mean - r.mean) <= 1e-9 * std::max(1.0, std::abs(r.mean));
+  });
+}
+
+std::pair<size_t, size_t> CachedRange(const chartview::series &data,
+                                      double xLow, double xHigh) {
+  const std::span<const chartview::point> points = data.points;
+  const auto first = static_cast<size_t>(
+      std::ranges::partition_point(
+          points, [xLow](const chartview::point &p) { return p.x < xLow; }) -
+      points.begin());
+  const auto last = static_cast<size_t>(
+      std::ranges::partition_point(
+          points, [xHigh](const chartview::point &p) { return p.x <= xHigh; }) -
+      points.begin());
+  return {first > 0 ? first - 1 : 0, std::min(last + 1, points.size())};
+}
+
+int main(int argc, char **argv) {
+  const unsigned seed =
+      argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10))
+               : 1;
+  std::mt19937 rng(seed);
+
+  TestDecimateMinMax(rng);
+  TestDecimationCache(rng);
+  TestFrameScheduler(rng);
+  TestHitCounts(rng);
+  TestLodPyramid(rng);
+  TestLttb(rng);
+  TestMinMaxIndex(rng);
+  TestRasterizer(rng);
+  TestReduceColumns(rng);
+  TestSampleQueue(rng);
+  TestSharedArray(rng);
+  TestSlidingMinMax(rng);
+  TestTickEngine(rng);
+  TestTiledSeries(rng);
+  TestVisibleRange(rng);
+
+  if (failures > 0) {
+    std::cerr << failures << " checks failed, seed " << seed << '\n';
+    return 1;
+  }
+  return 0;
+}
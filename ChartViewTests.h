@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ChartRenderer.h"
+#include "Decimation.h"
+
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
+
+// Shared by the files of ChartViewTests. Each file drives one part of the
+// pipeline with random data, compares it with the same result computed
+// from scratch or by brute force and reports every mismatch through Fail.
+
+void Fail(const std::string &what);
+
+// y on a grid of 1/64, sums of a few thousand stay exact
+double RandomY(std::mt19937 &rng);
+// Lowest and highest y of points [first, last)
+std::pair<double, double> BruteExtent(std::span<const chartview::point> points,
+                                      size_t first, size_t last);
+// Equal buckets, means up to rounding
+bool SameColumns(std::span<const chartview::bucket> a,
+                 std::span<const chartview::bucket> b);
+// Points [first, last) of data with x in [xLow, xHigh] and one neighbour on
+// either side, the range ChartRenderer gives DecimationCache::Update
+std::pair<size_t, size_t> CachedRange(const chartview::series &data,
+                                      double xLow, double xHigh);
+
+void TestDecimateMinMax(std::mt19937 &rng);
+void TestDecimationCache(std::mt19937 &rng);
+void TestFrameScheduler(std::mt19937 &rng);
+void TestHitCounts(std::mt19937 &rng);
+void TestLodPyramid(std::mt19937 &rng);
+void TestLttb(std::mt19937 &rng);
+void TestMinMaxIndex(std::mt19937 &rng);
+void TestRasterizer(std::mt19937 &rng);
+void TestReduceColumns(std::mt19937 &rng);
+void TestSampleQueue(std::mt19937 &rng);
+void TestSharedArray(std::mt19937 &rng);
+void TestSlidingMinMax(std::mt19937 &rng);
+void TestTickEngine(std::mt19937 &rng);
+void TestTiledSeries(std::mt19937 &rng);
+void TestVisibleRange(std::mt19937 &rng);
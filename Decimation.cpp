@@ -0,0 +1,295 @@
+#include "Decimation.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <future>
+
+namespace {
+// Data to pixel mapping taken from an axis aligned transform, evaluated
+// inline instead of through TransformPoint for every point
+struct pixelmap {
+  double ax;
+  double bx;
+  double ay;
+  double by;
+};
+
+pixelmap ToPixelMap(const wxAffineMatrix2D &transform) {
+  double x0 = 0;
+  double y0 = 0;
+  transform.TransformPoint(&x0, &y0);
+  double x1 = 1;
+  double y1 = 1;
+  transform.TransformPoint(&x1, &y1);
+  return {.ax = x1 - x0, .bx = x0, .ay = y1 - y0, .by = y0};
+}
+
+void CountHits(std::span<const chartview::point> points, const pixelmap &map,
+               int width, int height, std::span<std::uint32_t> counts) {
+  for (const auto &point : points) {
+    const double px = std::floor((map.ax * point.x) + map.bx);
+    const double py = std::floor((map.ay * point.y) + map.by);
+    if (!(px >= 0 && px < width && py >= 0 && py < height)) {
+      continue;
+    }
+    ++counts[(static_cast<size_t>(py) * width) + static_cast<size_t>(px)];
+  }
+}
+
+void EmitColumn(std::span<const chartview::point> points,
+                std::array<size_t, 4> indices,
+                std::pmr::vector<chartview::point> &out) {
+  std::ranges::sort(indices);
+  const auto last = std::ranges::unique(indices);
+
+  for (auto it = indices.begin(); it != last.begin(); ++it) {
+    out.push_back(points[*it]);
+  }
+}
+} // namespace
+
+std::pmr::vector<chartview::point>
+chartview::DecimateMinMax(std::span<const point> points, double xLow,
+                          double xHigh, int columns,
+                          std::pmr::memory_resource *resource) {
+  if (columns <= 0 || xHigh <= xLow ||
+      points.size() <= 4 * static_cast<size_t>(columns)) {
+    return {points.begin(), points.end(), resource};
+  }
+
+  const double columnsPerX = static_cast<double>(columns) / (xHigh - xLow);
+  // Clamped before the cast, neighbours beyond the view may lie arbitrarily
+  // far out of int range
+  auto columnOf = [&](double x) {
+    return static_cast<int>(std::clamp(std::floor((x - xLow) * columnsPerX),
+                                       0.0, static_cast<double>(columns - 1)));
+  };
+
+  std::pmr::vector<point> out(resource);
+  out.reserve(4 * static_cast<size_t>(columns));
+
+  int column = columnOf(points[0].x);
+  size_t first = 0;
+  size_t minIdx = 0;
+  size_t maxIdx = 0;
+
+  for (size_t i = 1; i < points.size(); ++i) {
+    const int c = columnOf(points[i].x);
+    if (c != column) {
+      EmitColumn(points, {first, minIdx, maxIdx, i - 1}, out);
+      column = c;
+      first = i;
+      minIdx = i;
+      maxIdx = i;
+      continue;
+    }
+
+    if (points[i].y < points[minIdx].y) {
+      minIdx = i;
+    }
+    if (points[i].y > points[maxIdx].y) {
+      maxIdx = i;
+    }
+  }
+  EmitColumn(points, {first, minIdx, maxIdx, points.size() - 1}, out);
+
+  return out;
+}
+
+std::pmr::vector<chartview::point>
+chartview::DecimateLttb(std::span<const point> points, size_t threshold,
+                        std::pmr::memory_resource *resource) {
+  const size_t n = points.size();
+  if (threshold >= n || threshold < 3) {
+    return {points.begin(), points.end(), resource};
+  }
+
+  std::pmr::vector<point> out(resource);
+  out.reserve(threshold);
+  out.push_back(points[0]);
+
+  // First and last point are kept, the rest is split into threshold - 2
+  // buckets
+  const double every =
+      static_cast<double>(n - 2) / static_cast<double>(threshold - 2);
+  auto bucketStart = [&](size_t bucket) {
+    return std::min(
+        static_cast<size_t>(static_cast<double>(bucket) * every) + 1, n - 1);
+  };
+
+  size_t a = 0;
+  for (size_t bucket = 0; bucket < threshold - 2; ++bucket) {
+    // Average of the next bucket, the last point for the final bucket
+    const size_t nextStart = bucketStart(bucket + 1);
+    const size_t nextEnd = std::max(bucketStart(bucket + 2), nextStart + 1);
+    double avgX = 0;
+    double avgY = 0;
+    for (size_t j = nextStart; j < nextEnd; ++j) {
+      avgX += points[j].x;
+      avgY += points[j].y;
+    }
+    avgX /= static_cast<double>(nextEnd - nextStart);
+    avgY /= static_cast<double>(nextEnd - nextStart);
+
+    // Twice the triangle area, the factor does not change the maximum
+    const point &pa = points[a];
+    double maxArea = -1;
+    size_t best = bucketStart(bucket);
+    for (size_t j = bucketStart(bucket); j < nextStart; ++j) {
+      const double area = std::abs(((pa.x - avgX) * (points[j].y - pa.y)) -
+                                   ((pa.x - points[j].x) * (avgY - pa.y)));
+      if (area > maxArea) {
+        maxArea = area;
+        best = j;
+      }
+    }
+
+    out.push_back(points[best]);
+    a = best;
+  }
+  out.push_back(points[n - 1]);
+
+  return out;
+}
+
+std::pmr::vector<chartview::bucket>
+chartview::ReduceColumns(std::span<const point> points, double xLow,
+                         double xHigh, int columns,
+                         std::pmr::memory_resource *resource) {
+  std::pmr::vector<bucket> out(resource);
+  if (columns <= 0 || points.empty()) {
+    return out;
+  }
+
+  const double columnsPerX =
+      xHigh > xLow ? static_cast<double>(columns) / (xHigh - xLow) : 0.0;
+  // Clamped before the cast, neighbours beyond the view may lie arbitrarily
+  // far out of int range
+  auto columnOf = [&](double x) {
+    return static_cast<int>(std::clamp(std::floor((x - xLow) * columnsPerX),
+                                       0.0, static_cast<double>(columns - 1)));
+  };
+
+  out.reserve(std::min(points.size(), static_cast<size_t>(columns)));
+
+  bucket current{.column = columnOf(points[0].x),
+                 .first = points[0].y,
+                 .min = points[0].y,
+                 .max = points[0].y,
+                 .last = points[0].y,
+                 .mean = 0};
+  double sum = points[0].y;
+  size_t count = 1;
+
+  for (size_t i = 1; i < points.size(); ++i) {
+    const int c = columnOf(points[i].x);
+    const double y = points[i].y;
+    if (c != current.column) {
+      current.mean = sum / static_cast<double>(count);
+      out.push_back(current);
+      current = {.column = c,
+                 .first = y,
+                 .min = y,
+                 .max = y,
+                 .last = y,
+                 .mean = 0};
+      sum = y;
+      count = 1;
+      continue;
+    }
+
+    current.min = std::min(current.min, y);
+    current.max = std::max(current.max, y);
+    current.last = y;
+    sum += y;
+    ++count;
+  }
+  current.mean = sum / static_cast<double>(count);
+  out.push_back(current);
+
+  return out;
+}
+
+std::pmr::vector<std::uint32_t>
+chartview::OccupiedPixels(std::span<const point> points,
+                          const wxAffineMatrix2D &transform, int width,
+                          int height, std::pmr::memory_resource *resource) {
+  std::pmr::vector<std::uint32_t> out(resource);
+  if (width <= 0 || height <= 0) {
+    return out;
+  }
+
+  const auto map = ToPixelMap(transform);
+  std::pmr::vector<std::uint8_t> grid(static_cast<size_t>(width) * height, 0,
+                                      resource);
+
+  for (const auto &point : points) {
+    const double px = std::floor((map.ax * point.x) + map.bx);
+    const double py = std::floor((map.ay * point.y) + map.by);
+    // Negated compare so NaN coordinates are dropped as well
+    if (!(px >= 0 && px < width && py >= 0 && py < height)) {
+      continue;
+    }
+
+    const auto index = (static_cast<std::uint32_t>(py) * width) +
+                       static_cast<std::uint32_t>(px);
+    if (grid[index] == 0) {
+      grid[index] = 1;
+      out.push_back(index);
+    }
+  }
+
+  return out;
+}
+
+std::pmr::vector<std::uint32_t>
+chartview::HitCounts(std::span<const point> points,
+                     const wxAffineMatrix2D &transform, int width, int height,
+                     ThreadPool *pool, std::pmr::memory_resource *resource) {
+  // Below this a single pass beats the cost of extra grids and tasks
+  constexpr size_t minPointsPerTask = size_t{1} << 20;
+
+  if (width <= 0 || height <= 0) {
+    return std::pmr::vector<std::uint32_t>(resource);
+  }
+
+  const auto map = ToPixelMap(transform);
+  const size_t cells = static_cast<size_t>(width) * height;
+  std::pmr::vector<std::uint32_t> counts(cells, 0, resource);
+
+  const size_t tasks =
+      pool == nullptr
+          ? 1
+          : std::clamp<size_t>(points.size() / minPointsPerTask, 1,
+                               pool->GetThreadCount());
+  if (tasks == 1) {
+    CountHits(points, map, width, height, counts);
+    return counts;
+  }
+
+  // The caller counts the first chunk into the result while the pool
+  // counts the rest into private grids
+  const size_t chunk = (points.size() + tasks - 1) / tasks;
+  std::vector<std::future<std::vector<std::uint32_t>>> partials;
+  partials.reserve(tasks - 1);
+  for (size_t t = 1; t < tasks; ++t) {
+    const auto slice = points.subspan(
+        t * chunk, std::min(chunk, points.size() - (t * chunk)));
+    partials.push_back(pool->Submit([slice, map, width, height, cells]() {
+      std::vector<std::uint32_t> partial(cells, 0);
+      CountHits(slice, map, width, height, partial);
+      return partial;
+    }));
+  }
+  CountHits(points.first(chunk), map, width, height, counts);
+
+  for (auto &future : partials) {
+    const auto partial = future.get();
+    for (size_t i = 0; i < cells; ++i) {
+      counts[i] += partial[i];
+    }
+  }
+
+  return counts;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ChartRenderer.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// All reductions allocate their results (and scratch grids) from resource,
+// so renderers can place them in a per frame arena.
+namespace chartview {
+// Per pixel column reduction of the series, y values of the first, lowest,
+// highest and last point falling into the column and their mean
+struct bucket {
+  int column;
+  double first;
+  double min;
+  double max;
+  double last;
+  double mean;
+};
+
+// Reduce points to at most four per pixel column (first, min, max and last
+// point of the column, in their original order) between xLow and xHigh.
+// The polyline through the result covers the same pixels as the polyline
+// through all points, but costs O(columns) to draw.
+std::pmr::vector<point> DecimateMinMax(
+    std::span<const point> points, double xLow, double xHigh, int columns,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+// Largest-Triangle-Three-Buckets downsampling to threshold points. Keeps
+// the first and last point and from each bucket in between the point
+// spanning the largest triangle with the previously kept point and the
+// average of the next bucket. Fewer points than DecimateMinMax and visually
+// close for smooth data, but not exact: narrow extremes can be dropped.
+std::pmr::vector<point> DecimateLttb(
+    std::span<const point> points, size_t threshold,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+// Same reduction as DecimateMinMax but kept per column, for renderers that
+// draw each column as a vertical span. Empty columns produce no bucket.
+std::pmr::vector<bucket> ReduceColumns(
+    std::span<const point> points, double xLow, double xHigh, int columns,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+// Distinct pixels of a width x height grid hit by the points, as indices
+// y * width + x in first hit order. transform maps data to grid pixels and
+// points falling outside the grid are dropped. Uses a one byte per pixel
+// occupancy grid, so the result is at most width * height long no matter
+// how many points there are.
+std::pmr::vector<std::uint32_t> OccupiedPixels(
+    std::span<const point> points, const wxAffineMatrix2D &transform,
+    int width, int height,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+// Number of points hitting each pixel of a width x height grid, indexed
+// y * width + x, with the same transform and clipping as OccupiedPixels.
+// Large inputs are split over the pool, each task counting its chunk into
+// a private grid in one streaming pass before the grids are summed.
+// The private grids of pool tasks are plain heap allocations.
+std::pmr::vector<std::uint32_t> HitCounts(
+    std::span<const point> points, const wxAffineMatrix2D &transform,
+    int width, int height, ThreadPool *pool = nullptr,
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+} // namespace chartview
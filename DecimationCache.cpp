@@ -0,0 +1,234 @@
+#include "DecimationCache.h"
+#include "ChartRenderer.h"
+#include "Decimation.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+// Zooming and panning by pixels round the viewport width a little
+// differently every time, widths this close share the cached columns
+constexpr double widthTolerance = 1e-9;
+// Keys stay exact integers well below this, x farther out in column widths
+// is not cached
+constexpr double keyLimit = 1e15;
+} // namespace
+
+bool DecimationCache::Update(const chartview::series &data, size_t first,
+                             size_t last, double xLow, double xHigh,
+                             int columns) {
+  m_reduced = 0;
+  if (!data.xSorted || columns <= 0 || !(xHigh > xLow) || first >= last) {
+    Clear();
+    return false;
+  }
+
+  const double dx = (xHigh - xLow) / columns;
+  if (std::abs(xLow / dx) > keyLimit || std::abs(xHigh / dx) > keyLimit) {
+    Clear();
+    return false;
+  }
+  if (data.generation != m_generation ||
+      std::abs(dx - m_dx) > widthTolerance * dx) {
+    m_columns.clear();
+    m_generation = data.generation;
+    m_dx = dx;
+  }
+  m_originKey = KeyOf(xLow);
+  m_count = columns;
+
+  const std::span<const chartview::point> points = data.points;
+  const size_t begin = data.evicted + first;
+  const size_t end = data.evicted + last;
+  const auto [cachedBegin, cachedEnd] = GetCachedRange();
+  m_begin = begin;
+  m_end = end;
+
+  if (m_columns.empty() || end <= cachedBegin || begin >= cachedEnd) {
+    // Jumped away from everything cached
+    m_columns.clear();
+    Reduce(points.subspan(first, last - first), begin, m_columns);
+  } else {
+    if (begin < cachedBegin) {
+      std::deque<column> head;
+      Reduce(points.subspan(first, cachedBegin - begin), begin, head);
+      if (head.back().key == m_columns.front().key) {
+        m_columns.front() = Merge(head.back(), m_columns.front());
+        head.pop_back();
+      }
+      m_columns.insert(m_columns.begin(), head.begin(), head.end());
+    }
+    if (end > cachedEnd) {
+      Reduce(points.subspan(cachedEnd - data.evicted, end - cachedEnd),
+             cachedEnd, m_columns);
+    }
+  }
+
+  // Columns scrolled out by more than a view width, but never one holding
+  // points given now
+  while (m_columns.front().key < m_originKey - columns &&
+         m_columns.front().last.position < begin) {
+    m_columns.pop_front();
+  }
+  while (m_columns.back().key >= m_originKey + (2 * std::int64_t{columns}) &&
+         m_columns.back().first.position >= end) {
+    m_columns.pop_back();
+  }
+
+  return true;
+}
+
+void DecimationCache::Clear() {
+  m_columns.clear();
+  m_dx = 0;
+}
+
+DecimationCache DecimationCache::Strip(const chartview::series &data,
+                                       size_t first, size_t last, double dx) {
+  DecimationCache strip;
+  if (!data.xSorted || !(dx > 0) || first >= last ||
+      last > data.points.size()) {
+    return strip;
+  }
+  strip.m_dx = dx;
+  strip.m_generation = data.generation;
+  strip.Reduce(std::span<const chartview::point>(data.points)
+                   .subspan(first, last - first),
+               data.evicted + first, strip.m_columns);
+  return strip;
+}
+
+bool DecimationCache::Splice(DecimationCache &&strip) {
+  // Keys of both are computed with the same dx, so it must match exactly
+  if (m_columns.empty() || strip.m_columns.empty() ||
+      strip.m_generation != m_generation || strip.m_dx != m_dx) {
+    return false;
+  }
+
+  const auto [cachedBegin, cachedEnd] = GetCachedRange();
+  const auto [stripBegin, stripEnd] = strip.GetCachedRange();
+  auto &added = strip.m_columns;
+  if (stripBegin == cachedEnd) {
+    if (added.front().key == m_columns.back().key) {
+      m_columns.back() = Merge(m_columns.back(), added.front());
+      added.pop_front();
+    }
+    m_columns.insert(m_columns.end(), added.begin(), added.end());
+    return true;
+  }
+  if (stripEnd == cachedBegin) {
+    if (added.back().key == m_columns.front().key) {
+      m_columns.front() = Merge(added.back(), m_columns.front());
+      added.pop_back();
+    }
+    m_columns.insert(m_columns.begin(), added.begin(), added.end());
+    return true;
+  }
+  return false;
+}
+
+double DecimationCache::GetColumnWidth() const {
+  return m_columns.empty() ? 0 : m_dx;
+}
+
+std::pair<size_t, size_t> DecimationCache::GetCachedRange() const {
+  if (m_columns.empty()) {
+    return {0, 0};
+  }
+  return {m_columns.front().first.position,
+          m_columns.back().last.position + 1};
+}
+
+std::pmr::vector<chartview::bucket>
+DecimationCache::Columns(std::pmr::memory_resource *resource) const {
+  std::pmr::vector<chartview::bucket> out(resource);
+  out.reserve(m_columns.size());
+  for (const auto &c : m_columns) {
+    if (!InView(c)) {
+      continue;
+    }
+    const auto index =
+        std::clamp<std::int64_t>(c.key - m_originKey, 0, m_count - 1);
+    out.push_back({.column = static_cast<int>(index),
+                   .first = c.first.y,
+                   .min = c.min.y,
+                   .max = c.max.y,
+                   .last = c.last.y,
+                   .mean = c.sum / static_cast<double>(c.count)});
+  }
+  return out;
+}
+
+std::pmr::vector<chartview::point>
+DecimationCache::MinMaxPoints(std::pmr::memory_resource *resource) const {
+  std::pmr::vector<chartview::point> out(resource);
+  out.reserve(4 * m_columns.size());
+  for (const auto &c : m_columns) {
+    if (!InView(c)) {
+      continue;
+    }
+    std::array<vertex, 4> picked{c.first, c.min, c.max, c.last};
+    std::ranges::sort(picked, {}, &vertex::position);
+    for (size_t i = 0; i < picked.size(); ++i) {
+      if (i == 0 || picked[i].position != picked[i - 1].position) {
+        out.push_back({.x = picked[i].x, .y = picked[i].y});
+      }
+    }
+  }
+  return out;
+}
+
+size_t DecimationCache::GetReducedCount() const { return m_reduced; }
+
+bool DecimationCache::InView(const column &c) const {
+  // A column straddling an edge is included whole
+  return c.last.position >= m_begin && c.first.position < m_end;
+}
+
+std::int64_t DecimationCache::KeyOf(double x) const {
+  // Neighbours drawn beyond the viewport may lie arbitrarily far out
+  return static_cast<std::int64_t>(
+      std::clamp(std::floor(x / m_dx), -keyLimit, keyLimit));
+}
+
+void DecimationCache::Reduce(std::span<const chartview::point> points,
+                             size_t position, std::deque<column> &columns) {
+  m_reduced += points.size();
+  for (const auto &point : points) {
+    const vertex v{.position = position++, .x = point.x, .y = point.y};
+    const std::int64_t key = KeyOf(v.x);
+    if (columns.empty() || columns.back().key != key) {
+      columns.push_back({.key = key,
+                         .count = 1,
+                         .sum = v.y,
+                         .first = v,
+                         .last = v,
+                         .min = v,
+                         .max = v});
+      continue;
+    }
+
+    auto &c = columns.back();
+    ++c.count;
+    c.sum += v.y;
+    c.last = v;
+    if (v.y < c.min.y) {
+      c.min = v;
+    }
+    if (v.y > c.max.y) {
+      c.max = v;
+    }
+  }
+}
+
+DecimationCache::column DecimationCache::Merge(const column &head,
+                                               const column &tail) {
+  // Ties go to the head, the earlier point, as when reducing in one pass
+  return {.key = head.key,
+          .count = head.count + tail.count,
+          .sum = head.sum + tail.sum,
+          .first = head.first,
+          .last = tail.last,
+          .min = tail.min.y < head.min.y ? tail.min : head.min,
+          .max = tail.max.y > head.max.y ? tail.max : head.max};
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace chartview {
+struct point;
+struct bucket;
+struct series;
+} // namespace chartview
+
+// Per column reduction of an append only series, kept from frame to frame.
+// Columns are aligned to multiples of their width dx in x rather than to
+// the viewport, so a complete column stays valid while points are appended
+// and while the view scrolls along the data. Update only reduces the points
+// it has not seen, those appended at the end or scrolled in at the start,
+// and drops the columns scrolled out, so a frame costs time in proportion
+// to the points added since the last one, not to the length of the series.
+// A new column width (zoom, resize) or series generation starts over from
+// the visible points.
+//
+// Columns up to one view width beyond either edge are kept, so panning back
+// and forth finds them cached, and columns reduced elsewhere (PanPrefetcher)
+// can be spliced on at either end.
+class DecimationCache {
+public:
+  // Cover points [first, last) of data with columns of width
+  // (xHigh - xLow) / columns. Returns false if the points cannot be cached
+  // (x not sorted, nothing visible), callers reduce them directly then.
+  bool Update(const chartview::series &data, size_t first, size_t last,
+              double xLow, double xHigh, int columns);
+  void Clear();
+
+  // A cache holding only points [first, last) of data in columns of width
+  // dx, made away from the drawing thread for Splice
+  static DecimationCache Strip(const chartview::series &data, size_t first,
+                               size_t last, double dx);
+  // Take over the columns of strip if it continues the cached points
+  // directly before or after them, in columns of the same width and series
+  // generation. Returns false and leaves the cache alone otherwise.
+  bool Splice(DecimationCache &&strip);
+
+  // Width of the cached columns, 0 when empty
+  [[nodiscard]] double GetColumnWidth() const;
+  // Positions [begin, end) of the cached points, see vertex
+  [[nodiscard]] std::pair<size_t, size_t> GetCachedRange() const;
+
+  // The columns holding points given to the last Update, numbered from the
+  // one holding xLow, like the result of ReduceColumns
+  [[nodiscard]] std::pmr::vector<chartview::bucket>
+  Columns(std::pmr::memory_resource *resource =
+              std::pmr::get_default_resource()) const;
+  // First, lowest, highest and last point of the same columns in their
+  // original order, like the result of DecimateMinMax
+  [[nodiscard]] std::pmr::vector<chartview::point>
+  MinMaxPoints(std::pmr::memory_resource *resource =
+                   std::pmr::get_default_resource()) const;
+
+  // Points reduced by the last Update, the others came from the cache
+  [[nodiscard]] size_t GetReducedCount() const;
+
+private:
+  // Points are identified by their position, the index they had before any
+  // were evicted, which does not change when the window moves
+  struct vertex {
+    size_t position;
+    double x;
+    double y;
+  };
+  struct column {
+    std::int64_t key;
+    size_t count;
+    double sum;
+    vertex first;
+    vertex last;
+    vertex min;
+    vertex max;
+  };
+
+  // Whether c holds points given to the last Update
+  [[nodiscard]] bool InView(const column &c) const;
+  [[nodiscard]] std::int64_t KeyOf(double x) const;
+  // Add points, which start at position, after the columns in columns
+  void Reduce(std::span<const chartview::point> points, size_t position,
+              std::deque<column> &columns);
+  // Combine two neighbouring parts of one column, head before tail
+  static column Merge(const column &head, const column &tail);
+
+  std::deque<column> m_columns;
+  double m_dx = 0;
+  size_t m_generation = 0;
+  // Key of the column holding xLow and the number of columns in view
+  std::int64_t m_originKey = 0;
+  int m_count = 0;
+  // Positions of the points given to the last Update
+  size_t m_begin = 0;
+  size_t m_end = 0;
+  size_t m_reduced = 0;
+};
@@ -0,0 +1,163 @@
+#include "ChartViewTests.h"
+#include "DecimationCache.h"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace {
+// Columns of a cache updated frame by frame compared with a fresh cache,
+// for a live series scrolling with its tail, with and without a window.
+// The edge columns may differ, the cached ones can hold points scrolled out
+// of the range given to Update.
+void TestDecimationCacheAppend(std::mt19937 &rng) {
+  constexpr int columns = 32;
+  constexpr double dx = 0.125;
+  for (const bool windowed : {false, true}) {
+    ChartRenderer renderer;
+    if (windowed) {
+      static_cast<void>(renderer.SetTimeWindow(40.0));
+    }
+    DecimationCache cache;
+    double x = 0;
+    bool followed = false;
+    for (int frame = 0; frame < 400; ++frame) {
+      std::vector<double> xs;
+      std::vector<double> ys;
+      const size_t count = rng() % 50;
+      for (size_t i = 0; i < count; ++i) {
+        x += static_cast<double>(rng() % 3 + 1) / 64;
+        xs.push_back(x);
+        ys.push_back(RandomY(rng));
+      }
+      static_cast<void>(frame == 0 ? renderer.SetPlotData(xs, ys)
+                                   : renderer.AppendPlotData(xs, ys));
+      const auto data = renderer.GetSeries();
+      if (data->points.empty()) {
+        continue;
+      }
+
+      // Mostly following the tail, sometimes looking back
+      const bool follow = frame % 7 != 3;
+      double xHigh = (std::floor(data->points.back().x / dx) + 1) * dx;
+      if (!follow) {
+        xHigh -= dx * static_cast<double>(rng() % 100);
+      }
+      const double xLow = xHigh - columns * dx;
+      const auto [first, last] = CachedRange(*data, xLow, xHigh);
+
+      DecimationCache fresh;
+      const bool updated =
+          cache.Update(*data, first, last, xLow, xHigh, columns);
+      if (updated != fresh.Update(*data, first, last, xLow, xHigh, columns)) {
+        Fail(std::format("DecimationCache frame {}: Update differs", frame));
+        continue;
+      }
+      if (!updated) {
+        followed = false;
+        continue;
+      }
+
+      const auto cached = cache.Columns();
+      const auto reference = fresh.Columns();
+      if (cached.size() != reference.size() ||
+          (cached.size() > 2 &&
+           !SameColumns(std::span(cached).subspan(1, cached.size() - 2),
+                        std::span(reference)
+                            .subspan(1, reference.size() - 2)))) {
+        Fail(std::format("DecimationCache frame {} window {}: columns differ "
+                         "from a fresh reduction",
+                         frame, windowed));
+      }
+      // Following the tail from frame to frame only reduces what arrived
+      if (follow && followed && cache.GetReducedCount() > count) {
+        Fail(std::format("DecimationCache frame {}: reduced {} points for {} "
+                         "appended",
+                         frame, cache.GetReducedCount(), count));
+      }
+      followed = follow;
+    }
+  }
+}
+
+// Strips reduced ahead of a pan in either direction and spliced on, as
+// PanPrefetcher does, compared with a fresh cache. The seam may fall inside
+// a column, whose two parts are merged.
+void TestDecimationCacheSplice(std::mt19937 &rng) {
+  constexpr int columns = 256;
+  constexpr double width = 64;
+  std::vector<double> xs;
+  std::vector<double> ys;
+  double x = 0;
+  for (int i = 0; i < 200'000; ++i) {
+    x += static_cast<double>(rng() % 3 + 1) / 64;
+    xs.push_back(x);
+    ys.push_back(RandomY(rng));
+  }
+  ChartRenderer renderer;
+  static_cast<void>(renderer.SetPlotData(xs, ys));
+  const auto data = renderer.GetSeries();
+
+  DecimationCache cache;
+  double xLow = x / 2;
+  double step = 0.4;
+  size_t spliced = 0;
+  for (int frame = 0; frame < 600; ++frame) {
+    if (frame == 300) {
+      step = -0.4;
+    }
+    const double xHigh = xLow + width;
+    const auto [first, last] = CachedRange(*data, xLow, xHigh);
+    if (!cache.Update(*data, first, last, xLow, xHigh, columns)) {
+      Fail(std::format("DecimationCache splice frame {}: Update failed",
+                       frame));
+      return;
+    }
+    DecimationCache fresh;
+    fresh.Update(*data, first, last, xLow, xHigh, columns);
+    const auto cached = cache.Columns();
+    const auto reference = fresh.Columns();
+    if (cached.size() != reference.size() || cached.size() < 3 ||
+        !SameColumns(
+            std::span(cached).subspan(1, cached.size() - 2),
+            std::span(reference).subspan(1, reference.size() - 2))) {
+      Fail(std::format("DecimationCache splice frame {}: columns differ "
+                       "from a fresh reduction",
+                       frame));
+    }
+
+    // Reduce the points the next three frames scroll in, ending or starting
+    // where the cached ones do
+    const auto [begin, end] = cache.GetCachedRange();
+    const double lead = 3 * std::abs(step);
+    std::pair<size_t, size_t> strip =
+        step > 0 ? CachedRange(*data, xHigh, xHigh + lead)
+                 : CachedRange(*data, xLow - lead, xLow);
+    strip = step > 0 ? std::pair{end, std::max(end, strip.second)}
+                     : std::pair{std::min(begin, strip.first), begin};
+    if (strip.first < strip.second &&
+        cache.Splice(DecimationCache::Strip(*data, strip.first, strip.second,
+                                            cache.GetColumnWidth()))) {
+      ++spliced;
+      if (cache.GetCachedRange() !=
+          std::pair{std::min(begin, strip.first),
+                    std::max(end, strip.second)}) {
+        Fail(std::format("DecimationCache splice frame {}: cached range not "
+                         "extended by the strip",
+                         frame));
+      }
+    }
+    xLow += step;
+  }
+  if (spliced == 0) {
+    Fail("DecimationCache splice: no strip was spliced");
+  }
+}
+} // namespace
+
+void TestDecimationCache(std::mt19937 &rng) {
+  TestDecimationCacheAppend(rng);
+  TestDecimationCacheSplice(rng);
+}
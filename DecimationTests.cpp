@@ -0,0 +1,200 @@
+#include "ChartViewTests.h"
+#include "Decimation.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <vector>
+
+namespace {
+// Columns DecimateMinMax puts x in, points beyond the view fall into the
+// edge columns
+int ColumnOf(double x, double xLow, double xHigh, int columns) {
+  return static_cast<int>(std::clamp(
+      std::floor((x - xLow) * columns / (xHigh - xLow)), 0.0,
+      static_cast<double>(columns - 1)));
+}
+
+// The first, lowest, highest and last point of every run of points in the
+// same column, in their order, from a scan of the points
+std::vector<chartview::point>
+BruteMinMax(const std::vector<chartview::point> &points, double xLow,
+            double xHigh, int columns) {
+  std::vector<chartview::point> out;
+  size_t first = 0;
+  while (first < points.size()) {
+    const int column = ColumnOf(points[first].x, xLow, xHigh, columns);
+    size_t last = first;
+    size_t low = first;
+    size_t high = first;
+    while (last + 1 < points.size() &&
+           ColumnOf(points[last + 1].x, xLow, xHigh, columns) == column) {
+      ++last;
+      low = points[last].y < points[low].y ? last : low;
+      high = points[last].y > points[high].y ? last : high;
+    }
+    std::array<size_t, 4> picked{first, low, high, last};
+    std::ranges::sort(picked);
+    for (size_t i = 0; i < picked.size(); ++i) {
+      if (i == 0 || picked[i] != picked[i - 1]) {
+        out.push_back(points[picked[i]]);
+      }
+    }
+    first = last + 1;
+  }
+  return out;
+}
+} // namespace
+
+// Min/max decimation of sorted and unsorted x, with points beyond the view
+// and ties in y, compared with a scan of every column
+void TestDecimateMinMax(std::mt19937 &rng) {
+  for (int round = 0; round < 300; ++round) {
+    const int columns = 1 + static_cast<int>(rng() % 50);
+    const size_t n = rng() % 2000;
+    const bool sorted = round % 4 != 0;
+    std::vector<chartview::point> points(n);
+    std::uniform_real_distribution<double> xs(-20, 120);
+    for (auto &p : points) {
+      p = {.x = xs(rng), .y = std::round(RandomY(rng) * 4)};
+    }
+    if (sorted) {
+      std::ranges::sort(points, {}, &chartview::point::x);
+    }
+
+    const auto decimated =
+        chartview::DecimateMinMax(points, 0, 100, columns);
+    const auto expected = 4 * static_cast<size_t>(columns) >= n
+                              ? points
+                              : BruteMinMax(points, 0, 100, columns);
+    if (!std::ranges::equal(decimated, expected, [](auto &a, auto &b) {
+          return a.x == b.x && a.y == b.y;
+        })) {
+      Fail(std::format("DecimateMinMax round {}: {} of {} points with {} "
+                       "columns differ from the scan{}",
+                       round, decimated.size(), n, columns,
+                       sorted ? "" : ", unsorted"));
+    }
+    if (sorted && decimated.size() > 4 * static_cast<size_t>(columns)) {
+      Fail(std::format("DecimateMinMax round {}: {} points for {} columns",
+                       round, decimated.size(), columns));
+    }
+  }
+
+  // Degenerate views keep all points
+  std::vector<chartview::point> many(100);
+  for (size_t i = 0; i < many.size(); ++i) {
+    many[i] = {.x = static_cast<double>(i), .y = RandomY(rng)};
+  }
+  if (chartview::DecimateMinMax(many, 1, 1, 10).size() != many.size() ||
+      chartview::DecimateMinMax(many, 0, 100, 0).size() != many.size()) {
+    Fail("DecimateMinMax: a degenerate view dropped points");
+  }
+}
+
+// Per pixel hit counts, split over a pool and not, and the occupied pixels
+// in first hit order, compared with counting each point's pixel
+void TestHitCounts(std::mt19937 &rng) {
+  constexpr int width = 37;
+  constexpr int height = 23;
+  const auto transform = ChartRenderer::PointsToPlotArea(
+      wxRect2DDouble(0, 0, width, height),
+      {.xLow = 0, .xHigh = width, .yLow = 0, .yHigh = height});
+  ThreadPool pool(4);
+
+  for (int round = 0; round < 3; ++round) {
+    // Pixel centres, far from the edges the mappings could round
+    // differently, some outside the grid and some not a number. The last
+    // round is large enough to be split over the pool.
+    const size_t n = round == 2 ? (size_t{5} << 20) : rng() % 5000;
+    std::vector<chartview::point> points(n);
+    for (auto &p : points) {
+      p = {.x = static_cast<double>(rng() % (width + 10)) - 4.5,
+           .y = static_cast<double>(rng() % (height + 10)) - 4.5};
+      if (rng() % 100 == 0) {
+        p.y = std::nan("");
+      }
+    }
+
+    std::vector<std::uint32_t> expected(static_cast<size_t>(width) * height);
+    std::vector<std::uint32_t> order;
+    for (const auto &p : points) {
+      double x = p.x;
+      double y = p.y;
+      transform.TransformPoint(&x, &y);
+      if (!(x >= 0 && x < width && y >= 0 && y < height)) {
+        continue;
+      }
+      const auto index = (static_cast<std::uint32_t>(y) * width) +
+                         static_cast<std::uint32_t>(x);
+      if (expected[index]++ == 0) {
+        order.push_back(index);
+      }
+    }
+
+    const auto single =
+        chartview::HitCounts(points, transform, width, height);
+    const auto pooled =
+        chartview::HitCounts(points, transform, width, height, &pool);
+    if (!std::ranges::equal(single, expected) ||
+        !std::ranges::equal(pooled, expected)) {
+      Fail(std::format("HitCounts round {}: counts of {} points differ",
+                       round, n));
+    }
+    if (!std::ranges::equal(
+            chartview::OccupiedPixels(points, transform, width, height),
+            order)) {
+      Fail(std::format("OccupiedPixels round {}: pixels of {} points differ",
+                       round, n));
+    }
+  }
+}
+
+// Per column buckets of sorted and unsorted x, compared with a scan of
+// every run of points in the same column
+void TestReduceColumns(std::mt19937 &rng) {
+  for (int round = 0; round < 300; ++round) {
+    const int columns = 1 + static_cast<int>(rng() % 50);
+    std::vector<chartview::point> points(rng() % 2000);
+    std::uniform_real_distribution<double> xs(-20, 120);
+    for (auto &p : points) {
+      p = {.x = xs(rng), .y = RandomY(rng)};
+    }
+    if (round % 4 != 0) {
+      std::ranges::sort(points, {}, &chartview::point::x);
+    }
+
+    std::vector<chartview::bucket> expected;
+    for (size_t first = 0; first < points.size();) {
+      const int column = ColumnOf(points[first].x, 0, 100, columns);
+      chartview::bucket b{.column = column,
+                          .first = points[first].y,
+                          .min = points[first].y,
+                          .max = points[first].y,
+                          .last = points[first].y,
+                          .mean = 0};
+      double sum = 0;
+      size_t last = first;
+      for (; last < points.size() &&
+             ColumnOf(points[last].x, 0, 100, columns) == column;
+           ++last) {
+        b.min = std::min(b.min, points[last].y);
+        b.max = std::max(b.max, points[last].y);
+        b.last = points[last].y;
+        sum += points[last].y;
+      }
+      b.mean = sum / static_cast<double>(last - first);
+      expected.push_back(b);
+      first = last;
+    }
+
+    if (!SameColumns(chartview::ReduceColumns(points, 0, 100, columns),
+                     expected)) {
+      Fail(std::format("ReduceColumns round {}: buckets of {} points with {} "
+                       "columns differ from the scan",
+                       round, points.size(), columns));
+    }
+  }
+}
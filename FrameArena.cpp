@@ -0,0 +1,61 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t initialCapacity)
+    : m_block(std::make_unique_for_overwrite<std::byte[]>(initialCapacity)),
+      m_capacity(initialCapacity), m_used(0), m_overflowBytes(0),
+      m_allocationCount(1) {}
+
+void FrameArena::Reset() {
+  if (!m_overflow.empty()) {
+    // Grow to what the last frame needed, with headroom for small changes
+    const size_t needed = m_used + m_overflowBytes;
+    m_overflow.clear();
+    m_overflowBytes = 0;
+    m_capacity = needed + (needed / 4);
+    m_block = std::make_unique_for_overwrite<std::byte[]>(m_capacity);
+    ++m_allocationCount;
+  }
+  m_used = 0;
+}
+
+size_t FrameArena::GetAllocationCount() const {
+  return m_allocationCount;
+}
+
+size_t FrameArena::GetCapacity() const {
+  return m_capacity;
+}
+
+void *FrameArena::do_allocate(size_t bytes, size_t alignment) {
+  const auto base = reinterpret_cast<std::uintptr_t>(m_block.get());
+  const std::uintptr_t aligned =
+      (base + m_used + alignment - 1) & ~(std::uintptr_t{alignment} - 1);
+  const size_t end = aligned - base + bytes;
+  if (end <= m_capacity) {
+    m_used = end;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  // Does not fit this frame, the block grows at the next Reset
+  m_overflow.push_back(
+      std::make_unique_for_overwrite<std::byte[]>(bytes + alignment));
+  m_overflowBytes += bytes + alignment;
+  ++m_allocationCount;
+
+  const auto overflow =
+      reinterpret_cast<std::uintptr_t>(m_overflow.back().get());
+  return reinterpret_cast<void *>((overflow + alignment - 1) &
+                                  ~(std::uintptr_t{alignment} - 1));
+}
+
+void FrameArena::do_deallocate(void * /*p*/, size_t /*bytes*/,
+                               size_t /*alignment*/) {
+  // Freed all at once by Reset
+}
+
+bool FrameArena::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  return this == &other;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for buffers that live for one frame. Memory is handed out
+// from one block and never freed individually, Reset rewinds the block for
+// the next frame. A frame that outgrows the block takes overflow blocks from
+// the heap, the next Reset replaces everything with a single block large
+// enough for that frame, so repainting a steady scene allocates nothing.
+class FrameArena : public std::pmr::memory_resource {
+public:
+  explicit FrameArena(size_t initialCapacity = 256 * 1024);
+
+  // Start a new frame, all memory handed out before becomes invalid
+  void Reset();
+
+  // Heap allocations made by the arena since construction
+  [[nodiscard]] size_t GetAllocationCount() const;
+  [[nodiscard]] size_t GetCapacity() const;
+
+private:
+  std::unique_ptr<std::byte[]> m_block;
+  size_t m_capacity;
+  size_t m_used;
+
+  std::vector<std::unique_ptr<std::byte[]>> m_overflow;
+  size_t m_overflowBytes;
+
+  size_t m_allocationCount;
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  [[nodiscard]] bool
+  do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
@@ -0,0 +1,70 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <format>
+
+FrameScheduler::FrameScheduler(double maxFps)
+    : m_interval(), m_pending(false), m_requests(0), m_coalesced(0),
+      m_frames(0), m_frameTimes() {
+  auto res = SetMaxFps(maxFps);
+  assert(res && "Frame rate is not positive!");
+}
+
+tl::expected<void, std::string> FrameScheduler::SetMaxFps(double maxFps) {
+  if (!std::isfinite(maxFps) || maxFps <= 0) {
+    return tl::make_unexpected(
+        std::format("scheduler error: frame rate {} is not positive", maxFps));
+  }
+
+  m_interval = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(1.0 / maxFps));
+  return {};
+}
+
+double FrameScheduler::GetMaxFps() const {
+  return 1.0 / std::chrono::duration<double>(m_interval).count();
+}
+
+std::optional<FrameScheduler::clock::duration>
+FrameScheduler::Request(clock::time_point now) {
+  ++m_requests;
+  if (m_pending) {
+    ++m_coalesced;
+    return std::nullopt;
+  }
+
+  m_pending = true;
+  if (!m_lastFrame || now - *m_lastFrame >= m_interval) {
+    return clock::duration::zero();
+  }
+  return *m_lastFrame + m_interval - now;
+}
+
+void FrameScheduler::FramePainted(clock::time_point now) {
+  m_pending = false;
+  m_lastFrame = now;
+  m_frameTimes.at(m_frames % fpsWindow) = now;
+  ++m_frames;
+}
+
+bool FrameScheduler::IsPending() const {
+  return m_pending;
+}
+
+chartview::framestatistics FrameScheduler::GetStatistics() const {
+  double fps = 0;
+  if (m_frames >= 2) {
+    const size_t count = std::min(m_frames, fpsWindow);
+    const auto newest = m_frameTimes.at((m_frames - 1) % fpsWindow);
+    const auto oldest = m_frameTimes.at((m_frames - count) % fpsWindow);
+    const double seconds =
+        std::chrono::duration<double>(newest - oldest).count();
+    fps = seconds > 0 ? static_cast<double>(count - 1) / seconds : 0;
+  }
+
+  return {.requests = m_requests,
+          .coalesced = m_coalesced,
+          .frames = m_frames,
+          .framesPerSecond = fps};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "expected.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace chartview {
+struct framestatistics {
+  // Invalidations asked for a frame, and how many of them were folded
+  // into a frame that was already pending
+  size_t requests;
+  size_t coalesced;
+  size_t frames;
+  // Over the last frames painted, 0 until two frames were painted
+  double framesPerSecond;
+};
+} // namespace chartview
+
+// Decides when a view repaints. Invalidations only mark a frame as pending
+// and frames are spaced at least 1 / maxFps apart, so data arriving much
+// faster than the display refreshes paints its latest state once per frame
+// instead of queueing a paint per update. Knows nothing about windows, the
+// owner starts a timer for the returned delay.
+class FrameScheduler {
+public:
+  using clock = std::chrono::steady_clock;
+
+  explicit FrameScheduler(double maxFps = 60);
+
+  tl::expected<void, std::string> SetMaxFps(double maxFps);
+  [[nodiscard]] double GetMaxFps() const;
+
+  // Ask for a frame. Returns the delay until it should be painted, or
+  // nothing if a frame is already pending and will show this update too.
+  std::optional<clock::duration> Request(clock::time_point now);
+  // A frame was painted, for whatever reason, the pending one is done
+  void FramePainted(clock::time_point now);
+  [[nodiscard]] bool IsPending() const;
+
+  [[nodiscard]] chartview::framestatistics GetStatistics() const;
+
+private:
+  static constexpr size_t fpsWindow = 32;
+
+  clock::duration m_interval;
+  bool m_pending;
+  std::optional<clock::time_point> m_lastFrame;
+
+  size_t m_requests;
+  size_t m_coalesced;
+  size_t m_frames;
+  // Ring of the last paint times, the frame rate is taken over its span
+  std::array<clock::time_point, fpsWindow> m_frameTimes;
+};
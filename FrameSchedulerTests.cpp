@@ -0,0 +1,124 @@
+#include "ChartViewTests.h"
+#include "FrameScheduler.h"
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <optional>
+
+namespace {
+using clock = FrameScheduler::clock;
+
+// Updates arriving at random times, faster and slower than the frame rate,
+// painted when the returned delay runs out as a view's timer would: one
+// pending frame at a time, frames at least an interval apart, never later
+// than an interval after the update they show, and every update shown
+void TestFrameRequests(std::mt19937 &rng) {
+  for (int round = 0; round < 50; ++round) {
+    const double maxFps = 10 + static_cast<double>(rng() % 200);
+    FrameScheduler scheduler(maxFps);
+    const auto interval = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / maxFps));
+    const auto what = std::format("FrameScheduler round {}", round);
+
+    clock::time_point now{};
+    std::optional<clock::time_point> paintAt;
+    std::optional<clock::time_point> lastPaint;
+    size_t requests = 0;
+    size_t scheduled = 0;
+    for (int update = 0; update < 2000; ++update) {
+      // Bursts of updates microseconds apart, then pauses of many frames
+      now += update % 100 < 90
+                 ? std::chrono::microseconds(rng() % 500)
+                 : std::chrono::microseconds(rng() % 200000);
+      while (paintAt && *paintAt <= now) {
+        if (lastPaint && *paintAt - *lastPaint < interval) {
+          Fail(std::format("{}: frames {} ns apart", what,
+                           (*paintAt - *lastPaint).count()));
+        }
+        scheduler.FramePainted(*paintAt);
+        lastPaint = paintAt;
+        paintAt.reset();
+      }
+
+      const bool pending = scheduler.IsPending();
+      const auto delay = scheduler.Request(now);
+      ++requests;
+      if (delay.has_value() == pending || !scheduler.IsPending()) {
+        Fail(std::format("{}: update {} pending {} got a frame {}", what,
+                         update, pending, delay.has_value()));
+        continue;
+      }
+      if (delay) {
+        if (*delay < clock::duration::zero() || *delay > interval) {
+          Fail(std::format("{}: update {} delayed {} ns", what, update,
+                           delay->count()));
+        }
+        paintAt = now + *delay;
+        ++scheduled;
+      }
+    }
+
+    const auto statistics = scheduler.GetStatistics();
+    if (statistics.requests != requests ||
+        statistics.coalesced != requests - scheduled ||
+        statistics.frames != scheduled - (paintAt ? 1 : 0)) {
+      Fail(std::format("{}: {} requests, {} coalesced and {} frames counted "
+                       "for {}, {} scheduled",
+                       what, statistics.requests, statistics.coalesced,
+                       statistics.frames, requests, scheduled));
+    }
+  }
+}
+
+// A stream far faster than the display paints the frame rate, measured
+// over the last frames
+void TestFrameRate() {
+  FrameScheduler scheduler(60);
+  clock::time_point now{};
+  auto paintAt = clock::time_point::max();
+  for (int update = 0; update < 2000; ++update) {
+    now += std::chrono::milliseconds(1);
+    if (paintAt <= now) {
+      scheduler.FramePainted(paintAt);
+      paintAt = clock::time_point::max();
+    }
+    if (const auto delay = scheduler.Request(now)) {
+      paintAt = now + *delay;
+    }
+  }
+
+  const auto statistics = scheduler.GetStatistics();
+  // Painted on the first millisecond tick after each interval
+  if (statistics.frames < 110 || statistics.frames > 121 ||
+      std::abs(statistics.framesPerSecond - 60) > 4) {
+    Fail(std::format("FrameScheduler: {} frames at {} fps in 2 s of updates "
+                     "limited to 60",
+                     statistics.frames, statistics.framesPerSecond));
+  }
+}
+
+void TestFrameRateLimits() {
+  FrameScheduler scheduler;
+  for (const double fps :
+       {0.0, -1.0, std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::infinity()}) {
+    if (scheduler.SetMaxFps(fps)) {
+      Fail(std::format("FrameScheduler: frame rate {} accepted", fps));
+    }
+  }
+  // Up to the interval rounded to the clock's nanoseconds
+  if (std::abs(scheduler.GetMaxFps() - 60) > 1e-3 ||
+      !scheduler.SetMaxFps(144) ||
+      std::abs(scheduler.GetMaxFps() - 144) > 1e-3) {
+    Fail(std::format("FrameScheduler: frame rate {} read back",
+                     scheduler.GetMaxFps()));
+  }
+}
+} // namespace
+
+void TestFrameScheduler(std::mt19937 &rng) {
+  TestFrameRequests(rng);
+  TestFrameRate();
+  TestFrameRateLimits();
+}
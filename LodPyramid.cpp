@@ -0,0 +1,370 @@
+#include "LodPyramid.h"
+#include "ChartRenderer.h"
+#include "Decimation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <random>
+
+namespace {
+// Nodes read per call while walking a level
+constexpr size_t readBatch = 256;
+} // namespace
+
+// One file per level holding its oldest nodes in order. Reads come from
+// drawing threads while the owner appends, the mutex serializes them.
+struct LodPyramid::spillfile {
+  explicit spillfile(std::filesystem::path dir)
+      : directory(std::move(dir)), token(std::random_device{}()) {}
+
+  spillfile(const spillfile &) = delete;
+  spillfile &operator=(const spillfile &) = delete;
+  spillfile(spillfile &&) = delete;
+  spillfile &operator=(spillfile &&) = delete;
+
+  ~spillfile() {
+    for (size_t k = 0; k < files.size(); ++k) {
+      files[k].close();
+      std::error_code ignored;
+      std::filesystem::remove(PathOf(k), ignored);
+    }
+  }
+
+  [[nodiscard]] std::filesystem::path PathOf(size_t k) const {
+    return directory / std::format("chartview-lod-{:08x}-{}.bin", token, k);
+  }
+
+  bool Write(size_t k, std::span<const node> nodes) {
+    std::scoped_lock lock(mutex);
+    while (files.size() <= k) {
+      files.emplace_back(PathOf(files.size()), std::ios::in | std::ios::out |
+                                                   std::ios::trunc |
+                                                   std::ios::binary);
+    }
+    auto &file = files[k];
+    file.seekp(0, std::ios::end);
+    file.write(reinterpret_cast<const char *>(nodes.data()),
+               static_cast<std::streamsize>(nodes.size_bytes()));
+    return static_cast<bool>(file.flush());
+  }
+
+  bool Read(size_t k, size_t first, std::span<node> out) {
+    std::scoped_lock lock(mutex);
+    if (k >= files.size()) {
+      return false;
+    }
+    auto &file = files[k];
+    file.seekg(static_cast<std::streamoff>(first * sizeof(node)));
+    file.read(reinterpret_cast<char *>(out.data()),
+              static_cast<std::streamsize>(out.size_bytes()));
+    return static_cast<bool>(file);
+  }
+
+  std::mutex mutex;
+  std::filesystem::path directory;
+  unsigned token;
+  std::vector<std::fstream> files;
+};
+
+tl::expected<void, std::string>
+LodPyramid::SetSpill(std::optional<std::filesystem::path> directory,
+                     size_t residentNodes) {
+  if (!directory) {
+    m_spill.reset();
+    m_residentNodes = 0;
+    Clear();
+    return {};
+  }
+
+  std::error_code error;
+  if (!std::filesystem::is_directory(*directory, error)) {
+    return tl::make_unexpected(std::format(
+        "plot error: spill directory {} does not exist", directory->string()));
+  }
+  if (residentNodes < 2) {
+    return tl::make_unexpected(std::format(
+        "plot error: {} resident nodes per level, at least 2 are needed",
+        residentNodes));
+  }
+
+  m_spill = std::make_shared<spillfile>(std::move(*directory));
+  m_residentNodes = residentNodes;
+  Clear();
+  return {};
+}
+
+void LodPyramid::Append(std::span<const chartview::point> points) {
+  if (!points.empty() && empty()) {
+    m_xFirst = points.front().x;
+  }
+  for (const auto &point : points) {
+    if (m_partial.count == 0) {
+      m_partial = {.xFirst = point.x,
+                   .xLast = point.x,
+                   .yFirst = point.y,
+                   .yLast = point.y,
+                   .yMin = point.y,
+                   .yMax = point.y,
+                   .sum = point.y,
+                   .count = 1};
+    } else {
+      m_partial.xLast = point.x;
+      m_partial.yLast = point.y;
+      m_partial.yMin = std::min(m_partial.yMin, point.y);
+      m_partial.yMax = std::max(m_partial.yMax, point.y);
+      m_partial.sum += point.y;
+      ++m_partial.count;
+    }
+
+    if (m_partial.count == blockSize) {
+      Push(0, m_partial);
+      m_partial = {};
+    }
+  }
+}
+
+void LodPyramid::Forget(double x) {
+  if (m_spill || empty()) {
+    return;
+  }
+  for (size_t k = 0; k < m_levels.size(); ++k) {
+    auto &l = m_levels[k];
+    // An unpaired last node still waits for its partner
+    const size_t unpaired = Size(k) % 2;
+    size_t count = 0;
+    while (count + unpaired < l.resident.size() &&
+           l.resident[count].xLast < x) {
+      ++count;
+    }
+    l.resident.erase_front(count);
+    l.forgotten += count;
+  }
+  m_xFirst = std::max(m_xFirst, x);
+}
+
+void LodPyramid::AppendNode(const node &block) {
+  if (block.count == 0) {
+    return;
+  }
+  if (m_levels.empty()) {
+    m_xFirst = block.xFirst;
+  }
+  Push(0, block);
+}
+
+void LodPyramid::SetPartial(const node &partial) {
+  if (m_levels.empty()) {
+    m_xFirst = partial.xFirst;
+  }
+  m_partial = partial;
+}
+
+void LodPyramid::Clear() {
+  m_levels.clear();
+  m_partial = {};
+  // Copies may still read the old files
+  if (m_spill) {
+    m_spill = std::make_shared<spillfile>(m_spill->directory);
+  }
+}
+
+bool LodPyramid::empty() const {
+  return m_levels.empty() && m_partial.count == 0;
+}
+
+std::optional<std::pair<double, double>> LodPyramid::XRange() const {
+  if (empty()) {
+    return std::nullopt;
+  }
+  double xLast = m_partial.xLast;
+  if (m_partial.count == 0) {
+    xLast = m_levels[0].resident.back().xLast;
+  }
+  return std::pair{m_xFirst, xLast};
+}
+
+size_t LodPyramid::GetResidentCount() const {
+  size_t count = 0;
+  for (const auto &l : m_levels) {
+    count += l.resident.size();
+  }
+  return count;
+}
+
+size_t LodPyramid::GetSpilledCount() const {
+  size_t count = 0;
+  for (const auto &l : m_levels) {
+    count += l.spilled;
+  }
+  return count;
+}
+
+std::pmr::vector<chartview::bucket>
+LodPyramid::Envelope(double xLow, double xHigh, int columns,
+                     std::pmr::memory_resource *resource) const {
+  std::pmr::vector<chartview::bucket> out(resource);
+  const auto range = XRange();
+  if (columns <= 0 || !(xHigh > xLow) || !range) {
+    return out;
+  }
+
+  // Coarsest level whose nodes are on average no wider than a column
+  const double dx = (xHigh - xLow) / columns;
+  const double width = range->second - range->first;
+  size_t k = 0;
+  for (size_t j = m_levels.size(); j-- > 0;) {
+    const size_t held = Size(j) - m_levels[j].forgotten;
+    if (held > 0 && width / static_cast<double>(held) <= dx) {
+      k = j;
+      break;
+    }
+  }
+
+  chartview::bucket current{};
+  double sum = 0;
+  std::uint64_t count = 0;
+  auto add = [&](const node &n) {
+    if (n.count == 0 || n.xLast < xLow || n.xFirst > xHigh) {
+      return;
+    }
+    const double position =
+        std::clamp(std::floor((n.xFirst - xLow) / dx), 0.0,
+                   static_cast<double>(columns - 1));
+    const auto column = static_cast<int>(position);
+    if (count > 0 && column == current.column) {
+      current.min = std::min(current.min, n.yMin);
+      current.max = std::max(current.max, n.yMax);
+      current.last = n.yLast;
+      sum += n.sum;
+      count += n.count;
+      return;
+    }
+    if (count > 0) {
+      current.mean = sum / static_cast<double>(count);
+      out.push_back(current);
+    }
+    current = {.column = column,
+               .first = n.yFirst,
+               .min = n.yMin,
+               .max = n.yMax,
+               .last = n.yLast,
+               .mean = 0};
+    sum = n.sum;
+    count = n.count;
+  };
+
+  if (!m_levels.empty()) {
+    // First node of level k reaching xLow, then along the level. Only
+    // spilled nodes are copied, into a buffer from resource.
+    std::pmr::vector<node> scratch(resource);
+    size_t lo = m_levels[k].forgotten;
+    size_t hi = Size(k);
+    while (lo < hi) {
+      const size_t mid = lo + ((hi - lo) / 2);
+      const auto probe = Nodes(k, mid, mid + 1, scratch);
+      if (!probe.empty() && probe.front().xLast < xLow) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    for (size_t i = lo; i < Size(k);) {
+      const auto batch =
+          Nodes(k, i, std::min(i + readBatch, Size(k)), scratch);
+      for (const auto &n : batch) {
+        add(n);
+      }
+      if (batch.empty() || batch.back().xFirst > xHigh) {
+        break;
+      }
+      i += batch.size();
+    }
+
+    // Points after the last node of level k: at most one unpaired node on
+    // each level below, then the partial block
+    for (size_t j = k; j-- > 0;) {
+      if (Size(j) % 2 == 1) {
+        add(m_levels[j].resident.back());
+      }
+    }
+  }
+  add(m_partial);
+
+  if (count > 0) {
+    current.mean = sum / static_cast<double>(count);
+    out.push_back(current);
+  }
+  return out;
+}
+
+LodPyramid::node LodPyramid::Combine(const node &a, const node &b) {
+  return {.xFirst = a.xFirst,
+          .xLast = b.xLast,
+          .yFirst = a.yFirst,
+          .yLast = b.yLast,
+          .yMin = std::min(a.yMin, b.yMin),
+          .yMax = std::max(a.yMax, b.yMax),
+          .sum = a.sum + b.sum,
+          .count = a.count + b.count};
+}
+
+size_t LodPyramid::Size(size_t k) const {
+  const auto &l = m_levels[k];
+  return l.forgotten + l.spilled + l.resident.size();
+}
+
+std::span<const LodPyramid::node>
+LodPyramid::Nodes(size_t k, size_t first, size_t last,
+                  std::pmr::vector<node> &scratch) const {
+  const auto &l = m_levels[k];
+  const size_t resident = l.forgotten + l.spilled;
+  if (first >= resident) {
+    return std::span<const node>(l.resident)
+        .subspan(first - resident, last - first);
+  }
+
+  // Nothing is forgotten while spilling, file offsets start at 0
+  scratch.resize(std::min(last, resident) - first);
+  if (!m_spill->Read(k, first - l.forgotten, scratch)) {
+    // Nodes that cannot be read back are left out
+    return {};
+  }
+  return scratch;
+}
+
+void LodPyramid::Push(size_t k, const node &added) {
+  if (m_levels.size() <= k) {
+    m_levels.push_back({.resident = {}, .spilled = 0, .forgotten = 0});
+  }
+  auto &resident = m_levels[k].resident;
+  resident.push_back(added);
+
+  // A completed pair carries into the level above
+  std::optional<node> carry;
+  if (Size(k) % 2 == 0) {
+    carry = Combine(resident[resident.size() - 2], resident.back());
+  }
+  Spill(k);
+  if (carry) {
+    Push(k + 1, *carry);
+  }
+}
+
+void LodPyramid::Spill(size_t k) {
+  auto &l = m_levels[k];
+  if (m_residentNodes == 0 || l.resident.size() <= 2 * m_residentNodes) {
+    return;
+  }
+
+  const size_t count = l.resident.size() - m_residentNodes;
+  if (!m_spill->Write(k, std::span<const node>(l.resident).first(count))) {
+    // Keep everything in memory rather than lose history
+    m_residentNodes = 0;
+    return;
+  }
+  l.resident.erase_front(count);
+  l.spilled += count;
+}
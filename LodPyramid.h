@@ -0,0 +1,124 @@
+#pragma once
+
+#include "SharedArray.h"
+#include "expected.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chartview {
+struct point;
+struct bucket;
+} // namespace chartview
+
+// Level of detail pyramid over a growing series with increasing x. Every
+// blockSize points are summarized into a level 0 node (x range, first,
+// last, lowest and highest y, sum) and levels are carried upwards like a
+// binary counter: when a level completes a pair, their combination is
+// appended to the level above. Appending costs amortized O(1) per point
+// and the per column envelope of any x range is read from the coarsest
+// level fine enough for it, O(columns + log n) however long the series.
+//
+// Nodes may outlive the points they summarize. Without a spill directory
+// Forget drops them along with the points, so the pyramid stays in
+// proportion to the points held. With a spill directory set the history is
+// kept instead: each level keeps only its newest nodes in memory and
+// appends the older ones to a file, so memory stays bounded while the
+// history is still summarized.
+//
+// Copies are snapshots like those of MinMaxIndex: they share node storage
+// and spill files with the original, which may keep appending on another
+// thread.
+class LodPyramid {
+public:
+  static constexpr size_t blockSize = 64;
+
+  // Summary of a run of consecutive points
+  struct node {
+    double xFirst;
+    double xLast;
+    double yFirst;
+    double yLast;
+    double yMin;
+    double yMax;
+    double sum;
+    std::uint64_t count;
+  };
+
+  // Keep at most residentNodes (at least 2) per level in memory, writing
+  // older nodes to files in directory that are removed with the last copy
+  // using them. Without a directory everything stays in memory. Clears the
+  // pyramid.
+  tl::expected<void, std::string>
+  SetSpill(std::optional<std::filesystem::path> directory,
+           size_t residentNodes);
+
+  // x must not decrease, also from one call to the next
+  void Append(std::span<const chartview::point> points);
+  // The points before x were dropped: drop the nodes summarizing only
+  // such points, unless they are kept in the spill files. A node holding
+  // points on both sides of x is kept whole.
+  void Forget(double x);
+  // For points summarized elsewhere and never seen by the pyramid, instead
+  // of Append: block stands for a complete run of any number of points as
+  // a level 0 node, partial for the points after the last block (count 0
+  // for none) and replaces the partial given before
+  void AppendNode(const node &block);
+  void SetPartial(const node &partial);
+  void Clear();
+
+  [[nodiscard]] bool empty() const;
+  // x range of every point appended
+  [[nodiscard]] std::optional<std::pair<double, double>> XRange() const;
+  // Nodes held in memory and written to the spill files
+  [[nodiscard]] size_t GetResidentCount() const;
+  [[nodiscard]] size_t GetSpilledCount() const;
+
+  // Per column extent, first, last and mean y of the points with x in
+  // [xLow, xHigh], columns as in ReduceColumns. Nodes are assigned to
+  // columns whole, so a column may include points up to one node width
+  // beyond its edges.
+  [[nodiscard]] std::pmr::vector<chartview::bucket>
+  Envelope(double xLow, double xHigh, int columns,
+           std::pmr::memory_resource *resource =
+               std::pmr::get_default_resource()) const;
+
+private:
+  struct level {
+    // The newest nodes, the ones before them are in the spill file
+    SharedArray<node> resident;
+    size_t spilled;
+    // Nodes forgotten before those, only while not spilling
+    size_t forgotten;
+  };
+  struct spillfile;
+
+  static node Combine(const node &a, const node &b);
+  // Nodes of level k ever pushed, including forgotten ones, which keeps
+  // the pairing of the binary counter
+  [[nodiscard]] size_t Size(size_t k) const;
+  // Nodes of level k from first on, at most up to last: resident ones in
+  // place, spilled ones read into scratch. Stops short where the spilled
+  // nodes end, returns none if they cannot be read. first is at least the
+  // forgotten count.
+  [[nodiscard]] std::span<const node>
+  Nodes(size_t k, size_t first, size_t last,
+        std::pmr::vector<node> &scratch) const;
+  void Push(size_t k, const node &added);
+  void Spill(size_t k);
+
+  std::vector<level> m_levels;
+  // Points after the last complete block or node
+  node m_partial{};
+  double m_xFirst = 0;
+  std::shared_ptr<spillfile> m_spill;
+  // 0 while not spilling
+  size_t m_residentNodes = 0;
+};
@@ -0,0 +1,101 @@
+#include "ChartViewTests.h"
+#include "LodPyramid.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Envelopes of a spilling pyramid and its snapshots compared with one held
+// in memory, and both with the points they summarize
+void TestLodPyramid(std::mt19937 &rng) {
+  const auto directory = std::filesystem::temp_directory_path() /
+                         ("ChartViewTests-" + std::to_string(rng()));
+  std::filesystem::create_directories(directory);
+  {
+    LodPyramid resident;
+    LodPyramid spilling;
+    if (auto spill = spilling.SetSpill(directory, 4); !spill) {
+      Fail(std::format("LodPyramid: {}", spill.error()));
+      return;
+    }
+
+    std::vector<chartview::point> points;
+    std::normal_distribution<double> walk;
+    double y = 0;
+    for (int round = 0; round < 200; ++round) {
+      std::vector<chartview::point> added;
+      const size_t count = rng() % 2000;
+      for (size_t i = 0; i < count; ++i) {
+        y += walk(rng);
+        added.push_back(
+            {.x = static_cast<double>(points.size() + added.size()), .y = y});
+      }
+      points.insert(points.end(), added.begin(), added.end());
+      resident.Append(added);
+      spilling.Append(added);
+      if (points.empty()) {
+        continue;
+      }
+
+      const LodPyramid snapshot = spilling;
+      const auto n = static_cast<double>(points.size());
+      const std::array<std::tuple<double, double, int>, 3> views{
+          {{0, n, 500}, {n * 0.3, n * 0.31, 100}, {n - 100, n, 50}}};
+      for (const auto &[xLow, xHigh, columns] : views) {
+        const auto envelope = snapshot.Envelope(xLow, xHigh, columns);
+        if (!SameColumns(envelope,
+                         resident.Envelope(xLow, xHigh, columns))) {
+          Fail(std::format("LodPyramid round {}: spilled envelope of "
+                           "[{}, {}] differs from the resident one",
+                           round, xLow, xHigh));
+        }
+
+        const auto inView = std::ranges::count_if(
+            points, [&](const auto &p) { return p.x >= xLow && p.x <= xHigh; });
+        const auto from = static_cast<size_t>(std::max(std::ceil(xLow), 0.0));
+        const auto extent = BruteExtent(
+            points, from, from + static_cast<size_t>(inView));
+        double low = std::numeric_limits<double>::infinity();
+        double high = -low;
+        for (size_t i = 0; i < envelope.size(); ++i) {
+          low = std::min(low, envelope[i].min);
+          high = std::max(high, envelope[i].max);
+          if (envelope[i].column < 0 || envelope[i].column >= columns ||
+              (i > 0 && envelope[i].column <= envelope[i - 1].column)) {
+            Fail(std::format("LodPyramid round {}: column {} out of order",
+                             round, envelope[i].column));
+          }
+        }
+        if (inView > 0 && (low > extent.first || high < extent.second)) {
+          Fail(std::format("LodPyramid round {}: envelope {}..{} misses "
+                           "the points' extent {}..{}",
+                           round, low, high, extent.first, extent.second));
+        }
+      }
+
+      double sum = 0;
+      for (const auto &p : points) {
+        sum += p.y;
+      }
+      const auto whole = snapshot.Envelope(-1, n + 1, 1);
+      if (whole.size() != 1 ||
+          std::abs(whole[0].mean - sum / n) >
+              1e-9 * std::max(1.0, std::abs(sum / n))) {
+        Fail(std::format("LodPyramid round {}: mean differs", round));
+      }
+    }
+    if (spilling.GetSpilledCount() == 0 ||
+        spilling.GetResidentCount() >= resident.GetResidentCount()) {
+      Fail("LodPyramid: nothing was spilled");
+    }
+  }
+  if (!std::filesystem::is_empty(directory)) {
+    Fail("LodPyramid: spill files left behind");
+  }
+  std::filesystem::remove_all(directory);
+}
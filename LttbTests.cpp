@@ -0,0 +1,284 @@
+#include "ChartViewTests.h"
+#include "StreamingLttb.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <vector>
+
+namespace {
+// Twice the area of the triangle a, b, c
+double Area(const chartview::point &a, const chartview::point &b, double x,
+            double y) {
+  return std::abs(((a.x - x) * (b.y - a.y)) - ((a.x - b.x) * (y - a.y)));
+}
+
+bool SamePoint(const chartview::point &a, const chartview::point &b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+// LTTB of points on buckets aligned to multiples of width, the way
+// StreamingLttb picks them: the first point, each bucket's pick towards the
+// average of the next one, the last bucket's towards the last point
+std::vector<chartview::point>
+BruteAlignedLttb(std::span<const chartview::point> points, double width) {
+  std::vector<chartview::point> out;
+  if (points.empty()) {
+    return out;
+  }
+  out.push_back(points.front());
+
+  // Runs [begin, end) of points with the same key, after the first point
+  std::vector<std::pair<size_t, size_t>> buckets;
+  for (size_t i = 1; i < points.size(); ++i) {
+    if (buckets.empty() || std::floor(points[i].x / width) !=
+                               std::floor(points[i - 1].x / width)) {
+      buckets.emplace_back(i, i + 1);
+    } else {
+      buckets.back().second = i + 1;
+    }
+  }
+
+  auto pick = [&](size_t begin, size_t end, double x, double y) {
+    size_t best = begin;
+    for (size_t i = begin; i < end; ++i) {
+      if (Area(out.back(), points[i], x, y) >
+          Area(out.back(), points[best], x, y)) {
+        best = i;
+      }
+    }
+    out.push_back(points[best]);
+  };
+  for (size_t b = 0; b + 1 < buckets.size(); ++b) {
+    const auto [nextBegin, nextEnd] = buckets[b + 1];
+    double x = 0;
+    double y = 0;
+    for (size_t i = nextBegin; i < nextEnd; ++i) {
+      x += points[i].x;
+      y += points[i].y;
+    }
+    const auto count = static_cast<double>(nextEnd - nextBegin);
+    pick(buckets[b].first, buckets[b].second, x / count, y / count);
+  }
+  if (!buckets.empty()) {
+    const auto [begin, end] = buckets.back();
+    if (end - begin > 1) {
+      pick(begin, end - 1, points.back().x, points.back().y);
+    }
+    out.push_back(points.back());
+  }
+  return out;
+}
+
+bool SamePoints(std::span<const chartview::point> a,
+                std::span<const chartview::point> b) {
+  return std::ranges::equal(a, b, SamePoint);
+}
+
+// DecimateLttb keeps threshold points, the first and the last among them,
+// in order, each spanning the largest triangle of its bucket
+void TestDecimateLttb(std::mt19937 &rng) {
+  for (int round = 0; round < 300; ++round) {
+    std::vector<chartview::point> points(rng() % 2000);
+    double x = 0;
+    for (auto &p : points) {
+      x += static_cast<double>(rng() % 4) / 64;
+      p = {.x = x, .y = RandomY(rng)};
+    }
+    const size_t threshold = rng() % 300;
+    const auto out = chartview::DecimateLttb(points, threshold);
+    const size_t n = points.size();
+    if (threshold >= n || threshold < 3) {
+      if (!SamePoints(out, points)) {
+        Fail(std::format("DecimateLttb round {}: {} points with threshold {} "
+                         "not kept",
+                         round, n, threshold));
+      }
+      continue;
+    }
+    if (out.size() != threshold || !SamePoint(out.front(), points.front()) ||
+        !SamePoint(out.back(), points.back())) {
+      Fail(std::format("DecimateLttb round {}: {} points of {} for threshold "
+                       "{}, or the ends dropped",
+                       round, out.size(), n, threshold));
+      continue;
+    }
+
+    // Bucket b holds points [start(b), start(b + 1)) after the first
+    const double every =
+        static_cast<double>(n - 2) / static_cast<double>(threshold - 2);
+    auto start = [&](size_t b) {
+      return std::min(static_cast<size_t>(static_cast<double>(b) * every) + 1,
+                      n - 1);
+    };
+    for (size_t b = 0; b + 2 < threshold; ++b) {
+      const size_t nextEnd = std::max(start(b + 2), start(b + 1) + 1);
+      double avgX = 0;
+      double avgY = 0;
+      for (size_t i = start(b + 1); i < nextEnd; ++i) {
+        avgX += points[i].x;
+        avgY += points[i].y;
+      }
+      avgX /= static_cast<double>(nextEnd - start(b + 1));
+      avgY /= static_cast<double>(nextEnd - start(b + 1));
+
+      const auto bucket =
+          std::span(points).subspan(start(b), start(b + 1) - start(b));
+      const chartview::point &kept = out[b + 1];
+      const double area = Area(out[b], kept, avgX, avgY);
+      if (std::ranges::none_of(bucket, [&](const chartview::point &p) {
+            return SamePoint(p, kept);
+          }) ||
+          std::ranges::any_of(bucket, [&](const chartview::point &p) {
+            return Area(out[b], p, avgX, avgY) > area;
+          })) {
+        Fail(std::format("DecimateLttb round {}: bucket {} does not keep its "
+                         "largest triangle",
+                         round, b));
+        break;
+      }
+    }
+  }
+}
+
+// A streaming LTTB following a live series frame by frame, with and
+// without a window. While the view follows the tail it only reads what was
+// appended and its picks are those of the same chain given every held
+// point from the view on; looking back, zooming or widening the view past
+// dropped picks starts over and picks as a fresh one.
+void TestStreamingLttb(std::mt19937 &rng) {
+  constexpr int width = 32;
+  constexpr double dx = 0.125;
+  for (const bool windowed : {false, true}) {
+    ChartRenderer renderer;
+    if (windowed) {
+      static_cast<void>(renderer.SetTimeWindow(40.0));
+    }
+    StreamingLttb lttb;
+    // Follows the same chain from its first point to the last held one
+    StreamingLttb chain;
+    size_t chainBegin = 0;
+    size_t end = 0;
+    bool atTail = false;
+    double x = 0;
+    double span = 4;
+    for (int frame = 0; frame < 400; ++frame) {
+      std::vector<double> xs;
+      std::vector<double> ys;
+      const size_t count = rng() % 50;
+      for (size_t i = 0; i < count; ++i) {
+        x += static_cast<double>(rng() % 3 + 1) / 64;
+        xs.push_back(x);
+        ys.push_back(RandomY(rng));
+      }
+      static_cast<void>(frame == 0 ? renderer.SetPlotData(xs, ys)
+                                   : renderer.AppendPlotData(xs, ys));
+      const auto data = renderer.GetSeries();
+      const std::span<const chartview::point> points = data->points;
+      if (points.empty()) {
+        continue;
+      }
+
+      // Mostly following the tail, sometimes looking back, zooming or
+      // widening the plot by as many columns as the view grows, which keeps
+      // the buckets but shows picks dropped before
+      const bool zoom = frame % 53 == 52;
+      if (zoom) {
+        span = span == 4 ? 6 : 4;
+      }
+      const int wide = frame % 29 == 28 ? 3 : 1;
+      const int columns = width * wide;
+      double xHigh = points.back().x + dx;
+      if (frame % 31 == 3) {
+        xHigh -= dx * static_cast<double>(rng() % 100);
+      }
+      const double xLow = xHigh - (span * wide);
+      const auto [first, last] = CachedRange(*data, xLow, xHigh);
+      const auto what =
+          std::format("StreamingLttb frame {} window {}", frame, windowed);
+
+      const bool updated =
+          lttb.Update(*data, first, last, xLow, xHigh, columns);
+      StreamingLttb fresh;
+      if (updated != fresh.Update(*data, first, last, xLow, xHigh, columns)) {
+        Fail(std::format("{}: Update differs from a fresh one", what));
+        continue;
+      }
+      if (!updated) {
+        end = 0;
+        atTail = false;
+        continue;
+      }
+
+      // Reading every given point is starting over, a view ending before
+      // the chain or with other buckets must
+      const bool restarted = lttb.GetReducedCount() == last - first;
+      const bool behind = data->evicted + last < end;
+      end = data->evicted + last;
+      const bool fromTail = atTail;
+      atTail = last == points.size();
+      if ((zoom || behind) && !restarted) {
+        Fail(std::format("{}: followed a view {}", what,
+                         zoom ? "zoomed" : "behind the chain"));
+      }
+
+      const auto picks = lttb.Points();
+      if (restarted) {
+        const auto reference =
+            BruteAlignedLttb(points.subspan(first, last - first),
+                             (xHigh - xLow) / (2.0 * columns));
+        if (!SamePoints(picks, reference) ||
+            !SamePoints(picks, fresh.Points())) {
+          Fail(std::format("{}: {} picks starting over, {} by brute force",
+                           what, picks.size(), reference.size()));
+        }
+        chain = fresh;
+        chainBegin = data->evicted + first;
+        continue;
+      }
+
+      static_cast<void>(chain.Update(
+          *data, chainBegin > data->evicted ? chainBegin - data->evicted : 0,
+          last, xLow, xHigh, columns));
+      // x is unique here, the picks from the last one before the view
+      const auto all = chain.Points();
+      auto from = std::ranges::lower_bound(all, points[first].x, {},
+                                           &chartview::point::x);
+      if (from != all.begin()) {
+        --from;
+      }
+      if (!SamePoints(picks, std::span(from, all.end()))) {
+        Fail(std::format("{}: {} picks are not the {} of the chain from the "
+                         "view",
+                         what, picks.size(), all.end() - from));
+      }
+      if (!SamePoint(picks.back(), points[last - 1]) ||
+          !std::ranges::is_sorted(picks, {}, &chartview::point::x) ||
+          picks.size() > (2 * static_cast<size_t>(columns)) + 6) {
+        Fail(std::format("{}: {} picks out of order, too many or without the "
+                         "last point",
+                         what, picks.size()));
+      }
+      if (fromTail && lttb.GetReducedCount() > count) {
+        Fail(std::format("{}: read {} points for {} appended", what,
+                         lttb.GetReducedCount(), count));
+      }
+    }
+  }
+
+  // Unsorted x is left to DecimateLttb
+  ChartRenderer renderer;
+  static_cast<void>(renderer.SetPlotData(std::vector<double>{0, 2, 1},
+                                         std::vector<double>{0, 1, 2}));
+  StreamingLttb lttb;
+  if (lttb.Update(*renderer.GetSeries(), 0, 3, 0, 2, 4)) {
+    Fail("StreamingLttb: followed unsorted x");
+  }
+}
+} // namespace
+
+void TestLttb(std::mt19937 &rng) {
+  TestDecimateLttb(rng);
+  TestStreamingLttb(rng);
+}
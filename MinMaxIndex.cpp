@@ -0,0 +1,126 @@
+#include "MinMaxIndex.h"
+#include "ChartRenderer.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr std::pair<double, double> emptyExtent{
+    std::numeric_limits<double>::infinity(),
+    -std::numeric_limits<double>::infinity()};
+
+std::pair<double, double> Combine(std::pair<double, double> a,
+                                  std::pair<double, double> b) {
+  return {std::min(a.first, b.first), std::max(a.second, b.second)};
+}
+
+std::pair<double, double> Scan(std::span<const chartview::point> points,
+                               size_t first, size_t last) {
+  auto extent = emptyExtent;
+  for (size_t i = first; i < last; ++i) {
+    extent.first = std::min(extent.first, points[i].y);
+    extent.second = std::max(extent.second, points[i].y);
+  }
+  return extent;
+}
+} // namespace
+
+void MinMaxIndex::Build(std::span<const chartview::point> points) {
+  Clear();
+  Update(points, 0);
+}
+
+void MinMaxIndex::Update(std::span<const chartview::point> points,
+                         size_t from) {
+  if (points.empty()) {
+    Clear();
+    return;
+  }
+
+  // Level 0, recompute the block holding from (it may have been partial)
+  // and every block after it. Blocks are in index positions, which count
+  // dropped points too.
+  const size_t end = m_base + points.size();
+  size_t changed = (m_base + from) / blockSize;
+  const size_t blocks = (end + blockSize - 1) / blockSize;
+  if (m_levels.empty()) {
+    m_levels.emplace_back();
+  }
+  m_levels[0].resize(blocks);
+  for (size_t b = changed; b < blocks; ++b) {
+    m_levels[0][b] = Scan(points, std::max(b * blockSize, m_base) - m_base,
+                          std::min(end, (b + 1) * blockSize) - m_base);
+  }
+
+  // Propagate the changed tail upwards until a single node is left
+  for (size_t k = 0; m_levels[k].size() > 1; ++k) {
+    if (m_levels.size() <= k + 1) {
+      m_levels.emplace_back();
+    }
+    const auto &below = m_levels[k];
+    auto &level = m_levels[k + 1];
+
+    level.resize((below.size() + 1) / 2);
+    changed /= 2;
+    for (size_t j = changed; j < level.size(); ++j) {
+      level[j] = 2 * j + 1 < below.size()
+                     ? Combine(below[2 * j], below[(2 * j) + 1])
+                     : below[2 * j];
+    }
+  }
+
+  // A shrinking series can leave stale levels on top
+  while (m_levels.size() > 1 && m_levels[m_levels.size() - 2].size() <= 1) {
+    m_levels.pop_back();
+  }
+}
+
+void MinMaxIndex::Drop(std::span<const chartview::point> points,
+                       size_t count) {
+  m_base += count;
+  // Keeps the levels within twice the points left
+  if (m_base > points.size()) {
+    Build(points);
+  }
+}
+
+void MinMaxIndex::Clear() {
+  m_levels.clear();
+  m_base = 0;
+}
+
+std::optional<std::pair<double, double>>
+MinMaxIndex::Query(std::span<const chartview::point> points, size_t first,
+                   size_t last) const {
+  last = std::min(last, points.size());
+  if (first >= last) {
+    return std::nullopt;
+  }
+
+  size_t b0 = (m_base + first + blockSize - 1) / blockSize;
+  size_t b1 = (m_base + last) / blockSize;
+  if (m_levels.empty() || b0 >= b1) {
+    // Range within one or two partial blocks
+    return Scan(points, first, last);
+  }
+
+  // Partial blocks at both ends are scanned directly. A block the front
+  // was dropped from is never whole within the range.
+  auto extent = Combine(Scan(points, first, (b0 * blockSize) - m_base),
+                        Scan(points, (b1 * blockSize) - m_base, last));
+
+  // Whole blocks [b0, b1) bottom up through the levels
+  for (size_t k = 0; b0 < b1 && k < m_levels.size(); ++k) {
+    const auto &level = m_levels[k];
+    if (b0 % 2 == 1) {
+      extent = Combine(extent, level[b0++]);
+    }
+    if (b1 % 2 == 1) {
+      extent = Combine(extent, level[--b1]);
+    }
+    b0 /= 2;
+    b1 /= 2;
+  }
+
+  return extent;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SharedArray.h"
+
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace chartview {
+struct point;
+} // namespace chartview
+
+// Min/max pyramid over the y values of a series. Level 0 holds the extent of
+// each block of blockSize points, every level above combines pairs of the
+// level below, like a segment tree over blocks. The y extent of any index
+// range is answered in O(blockSize + log n) with about n / 16 extra doubles.
+//
+// Copies are snapshots for the points indexed when they were made and stay
+// valid while the original is updated on another thread. Update only
+// writes entries of blocks that were partial or new, and Query only reads
+// entries of blocks that are complete within its range.
+class MinMaxIndex {
+public:
+  static constexpr size_t blockSize = 64;
+
+  void Build(std::span<const chartview::point> points);
+  // Bring the index up to date after points were appended at index from
+  void Update(std::span<const chartview::point> points, size_t from);
+  // The first count points were removed from the series, points is what is
+  // left. Blocks keep their place, the index is rebuilt once more points
+  // were dropped than are left.
+  void Drop(std::span<const chartview::point> points, size_t count);
+  void Clear();
+
+  // Extent of y over points [first, last), points must be the indexed series
+  [[nodiscard]] std::optional<std::pair<double, double>>
+  Query(std::span<const chartview::point> points, size_t first,
+        size_t last) const;
+
+private:
+  std::vector<SharedArray<std::pair<double, double>>> m_levels;
+  // Points dropped from the front since the last build, the index position
+  // of points[0]
+  size_t m_base = 0;
+};
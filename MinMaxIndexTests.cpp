@@ -0,0 +1,57 @@
+#include "ChartViewTests.h"
+#include "MinMaxIndex.h"
+#include "SharedArray.h"
+#include <format>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+// Queries of an index updated while points are appended and dropped,
+// compared with a scan of the points, also on snapshots made in between
+void TestMinMaxIndex(std::mt19937 &rng) {
+  SharedArray<chartview::point> points;
+  MinMaxIndex index;
+  std::optional<std::pair<SharedArray<chartview::point>, MinMaxIndex>>
+      snapshot;
+
+  auto check = [&](std::span<const chartview::point> indexed,
+                   const MinMaxIndex &queried, std::string_view what) {
+    for (int i = 0; i < 20; ++i) {
+      size_t first = rng() % (indexed.size() + 1);
+      size_t last = rng() % (indexed.size() + 1);
+      if (first > last) {
+        std::swap(first, last);
+      }
+      const auto extent = queried.Query(indexed, first, last);
+      if (extent.has_value() != (first < last) ||
+          (extent && *extent != BruteExtent(indexed, first, last))) {
+        Fail(std::format("MinMaxIndex {}: query of [{}, {}) differs", what,
+                         first, last));
+      }
+    }
+  };
+
+  for (int round = 0; round < 500; ++round) {
+    const size_t from = points.size();
+    const size_t count = rng() % 300;
+    for (size_t i = 0; i < count; ++i) {
+      points.push_back({.x = 0, .y = RandomY(rng)});
+    }
+    index.Update(points, from);
+
+    if (round % 3 == 0) {
+      const size_t dropped = rng() % (points.size() + 1);
+      points.erase_front(dropped);
+      index.Drop(points, dropped);
+    }
+    check(points, index, "updated");
+
+    if (snapshot) {
+      check(snapshot->first, snapshot->second, "snapshot");
+    }
+    if (round % 10 == 0) {
+      snapshot.emplace(points, index);
+    }
+  }
+}
@@ -0,0 +1,160 @@
+#include "PanPrefetcher.h"
+#include "ChartRenderer.h"
+#include "TiledSeries.h"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+namespace {
+// Weight of the newest pan in the smoothed speed
+constexpr double smoothing = 0.5;
+// Pans closer together than this are timed as this far apart, events
+// delivered in a burst would otherwise look infinitely fast
+constexpr auto minInterval = std::chrono::milliseconds(1);
+// The cache is in columns of the view when its width is this close
+constexpr double widthTolerance = 1e-9;
+} // namespace
+
+void PanPrefetcher::Pan(double dx, clock::time_point now) {
+  std::scoped_lock lock(m_mutex);
+  if (!m_lastPan || now - *m_lastPan > idle) {
+    // Starting to move, the speed is known from the next pan
+    m_velocity = 0;
+    m_lastPan = now;
+    return;
+  }
+
+  const double seconds =
+      std::chrono::duration<double>(std::max<clock::duration>(
+                                        now - *m_lastPan, minInterval))
+          .count();
+  m_velocity += smoothing * ((dx / seconds) - m_velocity);
+  m_lastPan = now;
+}
+
+double PanPrefetcher::GetVelocity(clock::time_point now) const {
+  std::scoped_lock lock(m_mutex);
+  if (!m_lastPan || now - *m_lastPan > idle) {
+    return 0;
+  }
+  return m_velocity;
+}
+
+void PanPrefetcher::Speculate(std::shared_ptr<const chartview::series> data,
+                              const chartview::viewport &view, int columns,
+                              const DecimationCache &cache,
+                              clock::time_point now) {
+  const double velocity = GetVelocity(now);
+  const double width = view.xHigh - view.xLow;
+  if (!data || velocity == 0 || columns <= 0 || !(width > 0)) {
+    return;
+  }
+  // Never more than a view width ahead, which the cache keeps
+  const double lead =
+      std::min(std::abs(velocity) *
+                   std::chrono::duration<double>(lookahead).count(),
+               width);
+  if (lead < width / columns) {
+    return;
+  }
+
+  std::scoped_lock lock(m_mutex);
+  if (m_busy) {
+    return;
+  }
+  if (!m_pool) {
+    m_pool = std::make_unique<ThreadPool>(1);
+  }
+
+  if (data->archive) {
+    // Summarized views read no chunks, closer ones page in the strip
+    if (data->archive->Summarizes(view.xLow, view.xHigh, columns)) {
+      return;
+    }
+    const double xLow = velocity > 0 ? view.xHigh : view.xLow - lead;
+    const double xHigh = velocity > 0 ? view.xHigh + lead : view.xLow;
+    m_busy = true;
+    static_cast<void>(
+        m_pool->Submit([this, archive = data->archive, xLow, xHigh]() {
+          static_cast<void>(archive->Points(xLow, xHigh));
+          std::scoped_lock done(m_mutex);
+          m_busy = false;
+        }));
+    return;
+  }
+
+  // A cache left from another zoom level, or not updated for this view,
+  // has nothing to continue
+  const double dx = cache.GetColumnWidth();
+  if (!(dx > 0) || std::abs(dx - (width / columns)) > widthTolerance * dx) {
+    return;
+  }
+  const auto range = StripRange(*data, view, velocity > 0 ? lead : -lead,
+                                cache.GetCachedRange());
+  if (!range) {
+    return;
+  }
+
+  m_busy = true;
+  static_cast<void>(
+      m_pool->Submit([this, data = std::move(data), range = *range, dx]() {
+        auto strip =
+            DecimationCache::Strip(*data, range.first, range.second, dx);
+        std::scoped_lock done(m_mutex);
+        m_ready = std::move(strip);
+        m_busy = false;
+      }));
+}
+
+std::optional<DecimationCache> PanPrefetcher::Take() {
+  std::scoped_lock lock(m_mutex);
+  return std::exchange(m_ready, std::nullopt);
+}
+
+std::optional<std::pair<size_t, size_t>>
+PanPrefetcher::StripRange(const chartview::series &data,
+                          const chartview::viewport &view, double lead,
+                          std::pair<size_t, size_t> cached) {
+  if (!data.xSorted || cached.first >= cached.second) {
+    return std::nullopt;
+  }
+
+  // Cached positions as indices, columns may hold points evicted since
+  const std::span<const chartview::point> points = data.points;
+  auto toIndex = [&](size_t position) {
+    return std::min(position - std::min(position, data.evicted),
+                    points.size());
+  };
+  auto lowerBound = [&](double x) {
+    return static_cast<size_t>(
+        std::ranges::partition_point(
+            points, [x](const chartview::point &p) { return p.x < x; }) -
+        points.begin());
+  };
+  auto upperBound = [&](double x) {
+    return static_cast<size_t>(
+        std::ranges::partition_point(
+            points, [x](const chartview::point &p) { return p.x <= x; }) -
+        points.begin());
+  };
+
+  const size_t begin = toIndex(cached.first);
+  const size_t end = toIndex(cached.second);
+  if (begin > lowerBound(view.xLow) || end < upperBound(view.xHigh)) {
+    return std::nullopt;
+  }
+
+  if (lead > 0) {
+    const size_t last = upperBound(view.xHigh + lead);
+    if (last <= end) {
+      return std::nullopt;
+    }
+    return std::pair{end, last};
+  }
+  const size_t first = lowerBound(view.xLow + lead);
+  if (first >= begin) {
+    return std::nullopt;
+  }
+  return std::pair{first, begin};
+}
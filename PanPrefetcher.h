@@ -0,0 +1,67 @@
+#pragma once
+
+#include "DecimationCache.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace chartview {
+struct series;
+struct viewport;
+} // namespace chartview
+
+// Works ahead of a pan on a background thread. Pans are timed to estimate
+// how fast the viewport moves, and after each frame the strip of data the
+// next frames are about to scroll in, the view moving on for lookahead at
+// that speed, is prepared:
+//   - for in memory series, reduced into columns of the decimation cache's
+//     width, which the next frame splices into the cache (Take, Splice)
+//     instead of reducing them on the drawing thread,
+//   - for archives drawn from their points, read into the chunk cache.
+// At most one strip is prepared at a time; a strip which no longer fits
+// the cache when it is done, because the view jumped or zoomed, is dropped.
+class PanPrefetcher {
+public:
+  using clock = std::chrono::steady_clock;
+
+  // How far ahead of the viewport to prepare, in time at the pan speed
+  static constexpr clock::duration lookahead = std::chrono::milliseconds(250);
+  // Without pans for this long the viewport is taken to stand still
+  static constexpr clock::duration idle = std::chrono::milliseconds(250);
+
+  // The viewport moved by dx in x (data units)
+  void Pan(double dx, clock::time_point now);
+  // Smoothed viewport speed in x units per second, negative to the left
+  [[nodiscard]] double GetVelocity(clock::time_point now) const;
+
+  // Prepare the strip ahead of view, which shows data in columns, given
+  // the state of the decimation cache after drawing it. Does nothing while
+  // the viewport stands still or a strip is still being prepared.
+  void Speculate(std::shared_ptr<const chartview::series> data,
+                 const chartview::viewport &view, int columns,
+                 const DecimationCache &cache, clock::time_point now);
+  // The columns of the last strip prepared, if it is done
+  std::optional<DecimationCache> Take();
+
+private:
+  // Range of points [first, last) of data ahead of the cached range
+  // cached, or nothing if the cache does not cover the view
+  static std::optional<std::pair<size_t, size_t>>
+  StripRange(const chartview::series &data, const chartview::viewport &view,
+             double lead, std::pair<size_t, size_t> cached);
+
+  mutable std::mutex m_mutex;
+  double m_velocity = 0;
+  std::optional<clock::time_point> m_lastPan;
+  bool m_busy = false;
+  std::optional<DecimationCache> m_ready;
+
+  // Started with the first strip, renderers that are never panned (batch
+  // jobs) run no thread. Last, so a strip being prepared finishes before
+  // the rest is destroyed.
+  std::unique_ptr<ThreadPool> m_pool;
+};
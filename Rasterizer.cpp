@@ -0,0 +1,348 @@
+#include "Rasterizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+int ToPixel(double v) {
+  // Coordinates far outside the buffer would overflow the integer stepping
+  constexpr double limit = 1 << 24;
+  return static_cast<int>(std::lround(std::clamp(v, -limit, limit)));
+}
+
+// Liang-Barsky clipping of the segment from x0, y0 to x1, y1 to the
+// rectangle [left, right] x [top, bottom]. Moves the ends onto the part
+// inside, returns false if there is none.
+bool ClipSegment(double &x0, double &y0, double &x1, double &y1, double left,
+                 double top, double right, double bottom) {
+  const double dx = x1 - x0;
+  const double dy = y1 - y0;
+  double t0 = 0;
+  double t1 = 1;
+  // The segment is inside an edge where p * t <= q
+  const std::array<std::pair<double, double>, 4> edges{{{-dx, x0 - left},
+                                                        {dx, right - x0},
+                                                        {-dy, y0 - top},
+                                                        {dy, bottom - y0}}};
+  for (const auto &[p, q] : edges) {
+    if (p == 0) {
+      if (q < 0) {
+        return false;
+      }
+    } else if (p < 0) {
+      t0 = std::max(t0, q / p);
+    } else {
+      t1 = std::min(t1, q / p);
+    }
+  }
+  if (t0 > t1) {
+    return false;
+  }
+
+  const double startX = x0;
+  const double startY = y0;
+  x0 = startX + (t0 * dx);
+  y0 = startY + (t0 * dy);
+  x1 = startX + (t1 * dx);
+  y1 = startY + (t1 * dy);
+  return true;
+}
+
+// 256 entry colour map interpolated between viridis anchor colours, from
+// dark blue for single hits to yellow for the densest pixel
+const std::array<chartview::rgb, 256> &HeatColours() {
+  static const auto colours = []() {
+    constexpr std::array<chartview::rgb, 5> anchors{
+        {{.r = 68, .g = 1, .b = 84},
+         {.r = 59, .g = 82, .b = 139},
+         {.r = 33, .g = 145, .b = 140},
+         {.r = 94, .g = 201, .b = 98},
+         {.r = 253, .g = 231, .b = 37}}};
+    std::array<chartview::rgb, 256> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+      const double pos =
+          static_cast<double>(i) * (anchors.size() - 1) / (table.size() - 1);
+      const auto low = std::min(static_cast<size_t>(pos), anchors.size() - 2);
+      const double f = pos - static_cast<double>(low);
+      auto lerp = [f](unsigned char a, unsigned char b) {
+        return static_cast<unsigned char>(std::lround(a + ((b - a) * f)));
+      };
+      table.at(i) = {.r = lerp(anchors.at(low).r, anchors.at(low + 1).r),
+                     .g = lerp(anchors.at(low).g, anchors.at(low + 1).g),
+                     .b = lerp(anchors.at(low).b, anchors.at(low + 1).b)};
+    }
+    return table;
+  }();
+  return colours;
+}
+} // namespace
+
+Rasterizer::Rasterizer(unsigned char *data, int width, int height,
+                       unsigned char *alpha)
+    : m_data(data), m_alpha(alpha), m_width(width), m_height(height),
+      m_clipLeft(0), m_clipTop(0), m_clipRight(width), m_clipBottom(height) {
+  assert(m_data && "rasterizer needs a pixel buffer");
+}
+
+Rasterizer::Rasterizer(wxImage &image)
+    : Rasterizer(image.GetData(), image.GetWidth(), image.GetHeight(),
+                 image.GetAlpha()) {
+}
+
+int Rasterizer::GetWidth() const {
+  return m_width;
+}
+
+int Rasterizer::GetHeight() const {
+  return m_height;
+}
+
+void Rasterizer::SetClip(int x, int y, int width, int height) {
+  m_clipLeft = std::clamp(x, 0, m_width);
+  m_clipTop = std::clamp(y, 0, m_height);
+  m_clipRight = std::clamp(x + width, m_clipLeft, m_width);
+  m_clipBottom = std::clamp(y + height, m_clipTop, m_height);
+}
+
+void Rasterizer::Fill(chartview::rgb colour) {
+  FillRect(0, 0, m_width, m_height, colour);
+}
+
+void Rasterizer::FillRect(int x, int y, int width, int height,
+                          chartview::rgb colour) {
+  const int x0 = std::max(x, m_clipLeft);
+  const int x1 = std::min(x + width, m_clipRight);
+  const int y0 = std::max(y, m_clipTop);
+  const int y1 = std::min(y + height, m_clipBottom);
+
+  for (int row = y0; row < y1; ++row) {
+    const size_t offset = (static_cast<size_t>(row) * m_width) + x0;
+    unsigned char *pixel = m_data + (offset * 3);
+    for (int col = x0; col < x1; ++col) {
+      *pixel++ = colour.r;
+      *pixel++ = colour.g;
+      *pixel++ = colour.b;
+    }
+    if (m_alpha != nullptr && x1 > x0) {
+      std::fill_n(m_alpha + offset, x1 - x0, 255);
+    }
+  }
+}
+
+void Rasterizer::DrawRect(int x, int y, int width, int height,
+                          chartview::rgb colour) {
+  DrawHLine(x, x + width - 1, y, colour);
+  DrawHLine(x, x + width - 1, y + height - 1, colour);
+  DrawVLine(x, y, y + height - 1, colour);
+  DrawVLine(x + width - 1, y, y + height - 1, colour);
+}
+
+void Rasterizer::DrawHLine(int x0, int x1, int y, chartview::rgb colour) {
+  if (x1 < x0) {
+    std::swap(x0, x1);
+  }
+  FillRect(x0, y, x1 - x0 + 1, 1, colour);
+}
+
+void Rasterizer::DrawVLine(int x, int y0, int y1, chartview::rgb colour) {
+  if (y1 < y0) {
+    std::swap(y0, y1);
+  }
+  FillRect(x, y0, 1, y1 - y0 + 1, colour);
+}
+
+void Rasterizer::DrawLine(double x0, double y0, double x1, double y1,
+                          chartview::rgb colour) {
+  // Clipped before stepping, so a segment from far off screen costs no
+  // more than its visible part. Pixel centres are at integer coordinates.
+  if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) ||
+      !std::isfinite(y1) ||
+      !ClipSegment(x0, y0, x1, y1, m_clipLeft - 0.5, m_clipTop - 0.5,
+                   m_clipRight - 0.5, m_clipBottom - 0.5)) {
+    return;
+  }
+
+  int px = ToPixel(x0);
+  int py = ToPixel(y0);
+  const int ex = ToPixel(x1);
+  const int ey = ToPixel(y1);
+
+  if (px == ex) {
+    DrawVLine(px, py, ey, colour);
+    return;
+  }
+  if (py == ey) {
+    DrawHLine(px, ex, py, colour);
+    return;
+  }
+
+  const int dx = std::abs(ex - px);
+  const int dy = -std::abs(ey - py);
+  const int sx = px < ex ? 1 : -1;
+  const int sy = py < ey ? 1 : -1;
+  int err = dx + dy;
+
+  while (true) {
+    Plot(px, py, colour);
+    if (px == ex && py == ey) {
+      break;
+    }
+    const int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      px += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      py += sy;
+    }
+  }
+}
+
+void Rasterizer::DrawPolyline(std::span<const chartview::point> points,
+                              chartview::rgb colour) {
+  for (size_t i = 1; i < points.size(); ++i) {
+    DrawLine(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y,
+             colour);
+  }
+}
+
+void Rasterizer::DrawColumnSpans(std::span<const chartview::bucket> buckets,
+                                 int left, chartview::rgb colour) {
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    const auto &b = buckets[i];
+    const int x = left + b.column;
+
+    if (i > 0) {
+      const auto &prev = buckets[i - 1];
+      DrawLine(left + prev.column, prev.last, x, b.first, colour);
+    }
+    DrawVLine(x, ToPixel(b.min), ToPixel(b.max), colour);
+  }
+}
+
+void Rasterizer::DrawBand(std::span<const chartview::bucket> buckets,
+                          int left, chartview::rgb fill, chartview::rgb line) {
+  for (const auto &b : buckets) {
+    DrawVLine(left + b.column, ToPixel(b.min), ToPixel(b.max), fill);
+  }
+  for (size_t i = 1; i < buckets.size(); ++i) {
+    const auto &prev = buckets[i - 1];
+    const auto &b = buckets[i];
+    DrawLine(left + prev.column, prev.mean, left + b.column, b.mean, line);
+  }
+  if (buckets.size() == 1) {
+    Plot(left + buckets[0].column, ToPixel(buckets[0].mean), line);
+  }
+}
+
+void Rasterizer::DrawHeatmap(std::span<const std::uint32_t> counts, int left,
+                             int top, int width) {
+  if (width <= 0 || counts.empty()) {
+    return;
+  }
+
+  const std::uint32_t maxCount = std::ranges::max(counts);
+  if (maxCount == 0) {
+    return;
+  }
+
+  const auto &colours = HeatColours();
+  const double scale = (colours.size() - 1) / std::log1p(maxCount);
+  const auto height = static_cast<int>(counts.size() / width);
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      const std::uint32_t count =
+          counts[(static_cast<size_t>(row) * width) + col];
+      if (count != 0) {
+        // Rounded, truncating could put the densest pixel a colour short
+        const auto index = std::min(
+            static_cast<size_t>(std::lround(std::log1p(count) * scale)),
+            colours.size() - 1);
+        Plot(left + col, top + row, colours.at(index));
+      }
+    }
+  }
+}
+
+void Rasterizer::Stamp(const chartview::marker &marker, int x, int y,
+                       chartview::rgb colour) {
+  const int half = marker.size / 2;
+  const int x0 = std::max(x - half, m_clipLeft);
+  const int x1 = std::min(x - half + marker.size, m_clipRight);
+  const int y0 = std::max(y - half, m_clipTop);
+  const int y1 = std::min(y - half + marker.size, m_clipBottom);
+
+  auto blend = [](unsigned char dst, unsigned char src, int coverage) {
+    return static_cast<unsigned char>(dst + ((src - dst) * coverage / 255));
+  };
+
+  for (int row = y0; row < y1; ++row) {
+    const unsigned char *mask =
+        marker.coverage.data() +
+        (static_cast<size_t>(row - y + half) * marker.size) + (x0 - x + half);
+    const size_t offset = (static_cast<size_t>(row) * m_width) + x0;
+    unsigned char *pixel = m_data + (offset * 3);
+    for (int col = x0; col < x1; ++col, ++mask, pixel += 3) {
+      const int coverage = *mask;
+      if (coverage == 0) {
+        continue;
+      }
+      pixel[0] = blend(pixel[0], colour.r, coverage);
+      pixel[1] = blend(pixel[1], colour.g, coverage);
+      pixel[2] = blend(pixel[2], colour.b, coverage);
+      if (m_alpha != nullptr) {
+        unsigned char &a = m_alpha[offset + (col - x0)];
+        a = std::max(a, static_cast<unsigned char>(coverage));
+      }
+    }
+  }
+}
+
+chartview::marker Rasterizer::CircleMarker(double radius) {
+  // 4x4 supersampling per pixel for the antialiased edge
+  constexpr int samples = 4;
+
+  const int size = (2 * static_cast<int>(std::ceil(radius))) + 1;
+  const double centre = size / 2.0;
+  chartview::marker marker{.size = size,
+                           .coverage = std::vector<unsigned char>(
+                               static_cast<size_t>(size) * size, 0)};
+
+  for (int row = 0; row < size; ++row) {
+    for (int col = 0; col < size; ++col) {
+      int inside = 0;
+      for (int sy = 0; sy < samples; ++sy) {
+        for (int sx = 0; sx < samples; ++sx) {
+          const double dx = col + ((sx + 0.5) / samples) - centre;
+          const double dy = row + ((sy + 0.5) / samples) - centre;
+          if ((dx * dx) + (dy * dy) <= radius * radius) {
+            ++inside;
+          }
+        }
+      }
+      marker.coverage[(static_cast<size_t>(row) * size) + col] =
+          static_cast<unsigned char>(inside * 255 / (samples * samples));
+    }
+  }
+
+  return marker;
+}
+
+void Rasterizer::Plot(int x, int y, chartview::rgb colour) {
+  if (x < m_clipLeft || y < m_clipTop || x >= m_clipRight ||
+      y >= m_clipBottom) {
+    return;
+  }
+
+  const size_t offset = (static_cast<size_t>(y) * m_width) + x;
+  unsigned char *pixel = m_data + (offset * 3);
+  pixel[0] = colour.r;
+  pixel[1] = colour.g;
+  pixel[2] = colour.b;
+  if (m_alpha != nullptr) {
+    m_alpha[offset] = 255;
+  }
+}
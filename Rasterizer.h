@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ChartRenderer.h"
+#include "Decimation.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace chartview {
+struct rgb {
+  unsigned char r;
+  unsigned char g;
+  unsigned char b;
+};
+
+// Pre-rendered marker, a size x size coverage mask centred on the pixel it
+// is stamped at
+struct marker {
+  int size;
+  std::vector<unsigned char> coverage;
+};
+} // namespace chartview
+
+// Minimal software drawing into a packed 24 bit RGB buffer, the layout used
+// by wxImage::GetData(). No wx GDI objects are touched, so separate
+// rasterizers can run concurrently on worker threads.
+class Rasterizer {
+public:
+  Rasterizer(unsigned char *data, int width, int height,
+             unsigned char *alpha = nullptr);
+  // Draws into the image's alpha channel as well when it has one
+  explicit Rasterizer(wxImage &image);
+
+  [[nodiscard]] int GetWidth() const;
+  [[nodiscard]] int GetHeight() const;
+
+  // Restrict all drawing to a rectangle, the whole buffer by default
+  void SetClip(int x, int y, int width, int height);
+
+  void Fill(chartview::rgb colour);
+  void FillRect(int x, int y, int width, int height, chartview::rgb colour);
+  void DrawRect(int x, int y, int width, int height, chartview::rgb colour);
+  void DrawHLine(int x0, int x1, int y, chartview::rgb colour);
+  void DrawVLine(int x, int y0, int y1, chartview::rgb colour);
+
+  // Aliased (Bresenham) line, clipped to the clip rectangle. Ends that are
+  // not finite draw nothing.
+  void DrawLine(double x0, double y0, double x1, double y1,
+                chartview::rgb colour);
+  void DrawPolyline(std::span<const chartview::point> points,
+                    chartview::rgb colour);
+
+  // Dense line fast path. Buckets hold pixel y values, each is drawn as a
+  // vertical min/max span at x = left + column and joined to its neighbour
+  // with a segment from last to first, matching the aliased polyline.
+  void DrawColumnSpans(std::span<const chartview::bucket> buckets, int left,
+                       chartview::rgb colour);
+
+  // Envelope of the buckets (pixel y values as for DrawColumnSpans), each
+  // column filled from min to max, with the line through the column means
+  // drawn on top
+  void DrawBand(std::span<const chartview::bucket> buckets, int left,
+                chartview::rgb fill, chartview::rgb line);
+
+  // Density heatmap of per pixel hit counts (width wide, as returned by
+  // HitCounts) with its top left corner at left, top. Counts are log scaled
+  // against the largest one and coloured with a viridis style map, pixels
+  // without hits are left untouched.
+  void DrawHeatmap(std::span<const std::uint32_t> counts, int left, int top,
+                   int width);
+
+  // Blend the marker into the buffer centred at x, y
+  void Stamp(const chartview::marker &marker, int x, int y,
+             chartview::rgb colour);
+  // Antialiased filled circle, rendered once and stamped per point
+  static chartview::marker CircleMarker(double radius);
+
+private:
+  unsigned char *m_data;
+  unsigned char *m_alpha;
+  int m_width;
+  int m_height;
+
+  // Clip rectangle as [left, right) x [top, bottom)
+  int m_clipLeft;
+  int m_clipTop;
+  int m_clipRight;
+  int m_clipBottom;
+
+  void Plot(int x, int y, chartview::rgb colour);
+};
@@ -0,0 +1,269 @@
+#include "ChartViewTests.h"
+#include "Decimation.h"
+#include "Rasterizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int width = 64;
+constexpr int height = 48;
+constexpr chartview::rgb black{.r = 0, .g = 0, .b = 0};
+
+std::vector<unsigned char> WhiteBuffer() {
+  return std::vector<unsigned char>(static_cast<size_t>(width) * height * 3,
+                                    255);
+}
+
+bool Drawn(const std::vector<unsigned char> &buffer, int x, int y) {
+  return buffer[((static_cast<size_t>(y) * width) + x) * 3] == 0;
+}
+
+// Lines with ends far off screen against a random clip rectangle: only
+// pixels inside it, each within a pixel of the line, and no gaps
+void TestRasterizerLines(std::mt19937 &rng) {
+  std::uniform_real_distribution<double> near(-20, 80);
+  std::uniform_real_distribution<double> far(-1e9, 1e9);
+  for (int round = 0; round < 500; ++round) {
+    auto end = [&]() { return round % 2 == 0 ? near(rng) : far(rng); };
+    const double x0 = end();
+    const double y0 = near(rng);
+    const double x1 = end();
+    const double y1 = round % 3 == 0 ? end() : near(rng);
+    const int left = static_cast<int>(rng() % 20);
+    const int top = static_cast<int>(rng() % 20);
+    const int right = left + 1 + static_cast<int>(rng() % (width - left));
+    const int bottom = top + 1 + static_cast<int>(rng() % (height - top));
+
+    auto buffer = WhiteBuffer();
+    Rasterizer raster(buffer.data(), width, height);
+    raster.SetClip(left, top, right - left, bottom - top);
+    raster.DrawLine(x0, y0, x1, y1, black);
+
+    const double dx = x1 - x0;
+    const double dy = y1 - y0;
+    const bool xMajor = std::abs(dx) >= std::abs(dy);
+    // Distance of a pixel from the line. Rounding the ends moves the line
+    // by up to half a pixel on either axis and stepping adds half a pixel,
+    // together less than 1.25.
+    auto offset = [&](double x, double y) {
+      return std::abs((dx * (y - y0)) - (dy * (x - x0))) / std::hypot(dx, dy);
+    };
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        if (!Drawn(buffer, x, y)) {
+          continue;
+        }
+        if (x < left || x >= right || y < top || y >= bottom) {
+          Fail(std::format("Rasterizer round {}: {}, {} outside the clip",
+                           round, x, y));
+        } else if (offset(x, y) > 1.25) {
+          Fail(std::format("Rasterizer round {}: {}, {} is {} off the line",
+                           round, x, y, offset(x, y)));
+        }
+      }
+    }
+
+    // Every column (row) the line crosses well inside the clip has a pixel
+    for (int i = 0; i < (xMajor ? width : height); ++i) {
+      const double t = (i - (xMajor ? x0 : y0)) / (xMajor ? dx : dy);
+      const double minor = xMajor ? y0 + (t * dy) : x0 + (t * dx);
+      const double major = (xMajor ? dx : dy) * t;
+      const int low = xMajor ? top : left;
+      const int high = xMajor ? bottom : right;
+      if (!(t > 0 && t < 1) || std::abs(major) < 1 ||
+          std::abs(major - (xMajor ? dx : dy)) < 1 ||
+          i < (xMajor ? left : top) || i >= (xMajor ? right : bottom) ||
+          minor < low + 1.5 || minor > high - 2.5) {
+        continue;
+      }
+      bool hit = false;
+      for (int j = low; j < high; ++j) {
+        hit = hit || (xMajor ? Drawn(buffer, i, j) : Drawn(buffer, j, i));
+      }
+      if (!hit) {
+        Fail(std::format("Rasterizer round {}: gap at {} {}", round,
+                         xMajor ? "column" : "row", i));
+      }
+    }
+  }
+}
+
+// Column spans of the reduced points cover exactly the pixels of the
+// polyline through all of them, x on pixel columns and y partly off the
+// buffer
+void TestRasterizerSpans(std::mt19937 &rng) {
+  std::uniform_real_distribution<double> ys(-30, height + 30);
+  for (int round = 0; round < 200; ++round) {
+    std::vector<chartview::point> points;
+    for (int x = 0; x < width; ++x) {
+      const size_t count = rng() % 4;
+      for (size_t i = 0; i < count; ++i) {
+        points.push_back({.x = static_cast<double>(x), .y = ys(rng)});
+      }
+    }
+    const int left = static_cast<int>(rng() % 10);
+    const int top = static_cast<int>(rng() % 10);
+
+    auto polyline = WhiteBuffer();
+    auto spans = WhiteBuffer();
+    Rasterizer byLine(polyline.data(), width, height);
+    Rasterizer bySpan(spans.data(), width, height);
+    byLine.SetClip(left, top, width - (2 * left), height - (2 * top));
+    bySpan.SetClip(left, top, width - (2 * left), height - (2 * top));
+    byLine.DrawPolyline(points, black);
+    bySpan.DrawColumnSpans(
+        chartview::ReduceColumns(points, 0, width, width), 0, black);
+    if (polyline != spans) {
+      Fail(std::format("Rasterizer round {}: spans of {} points differ "
+                       "from the polyline",
+                       round, points.size()));
+    }
+  }
+
+  // Ends that are not finite draw nothing
+  auto buffer = WhiteBuffer();
+  Rasterizer raster(buffer.data(), width, height);
+  raster.DrawLine(0, 0, std::nan(""), 10, black);
+  raster.DrawLine(0, 0, 10, std::numeric_limits<double>::infinity(), black);
+  if (buffer != WhiteBuffer()) {
+    Fail("Rasterizer: a line to a non finite end was drawn");
+  }
+}
+
+// Heatmap of random counts at an offset, partly beyond the buffer: pixels
+// without hits untouched, the densest in the last colour, and colours
+// rising with the count (the green channel of the map rises throughout)
+void TestRasterizerHeatmap(std::mt19937 &rng) {
+  constexpr int gridWidth = 20;
+  constexpr int gridHeight = 15;
+  constexpr std::array<unsigned char, 3> untouched{255, 255, 255};
+  constexpr std::array<unsigned char, 3> last{253, 231, 37};
+  for (int round = 0; round < 50; ++round) {
+    std::vector<std::uint32_t> counts(static_cast<size_t>(gridWidth) *
+                                      gridHeight);
+    for (auto &count : counts) {
+      count = rng() % 3 == 0 ? 0 : rng() % (1 + (rng() % 100000));
+    }
+    const std::uint32_t densest = std::ranges::max(counts);
+    const int left = static_cast<int>(rng() % 50);
+    const int top = static_cast<int>(rng() % 40);
+
+    auto buffer = WhiteBuffer();
+    Rasterizer raster(buffer.data(), width, height);
+    raster.DrawHeatmap(counts, left, top, gridWidth);
+
+    std::vector<std::pair<std::uint32_t, unsigned char>> greens;
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const bool inside = x >= left && x < left + gridWidth && y >= top &&
+                            y < top + gridHeight;
+        const std::uint32_t count =
+            inside ? counts[(static_cast<size_t>(y - top) * gridWidth) +
+                            (x - left)]
+                   : 0;
+        const size_t offset = ((static_cast<size_t>(y) * width) + x) * 3;
+        const std::array<unsigned char, 3> colour{
+            buffer[offset], buffer[offset + 1], buffer[offset + 2]};
+        if ((count == 0 && colour != untouched) ||
+            (count > 0 && count == densest && colour != last)) {
+          Fail(std::format("Rasterizer heatmap round {}: {}, {} with {} of "
+                           "{} hits coloured {} {} {}",
+                           round, x, y, count, densest, colour[0], colour[1],
+                           colour[2]));
+        }
+        if (count > 0) {
+          greens.emplace_back(count, colour[1]);
+        }
+      }
+    }
+
+    std::ranges::sort(greens);
+    for (size_t i = 1; i < greens.size(); ++i) {
+      if (greens[i].second < greens[i - 1].second) {
+        Fail(std::format("Rasterizer heatmap round {}: {} hits drawn "
+                         "darker than {}",
+                         round, greens[i].first, greens[i - 1].first));
+      }
+    }
+  }
+}
+
+// Band of random buckets with gaps: each bucket's column filled from min to
+// max under the mean line, nothing else drawn but the line
+void TestRasterizerBand(std::mt19937 &rng) {
+  constexpr chartview::rgb fill{.r = 0, .g = 0, .b = 200};
+  constexpr chartview::rgb line{.r = 200, .g = 0, .b = 0};
+  std::uniform_real_distribution<double> ys(-10, height + 10);
+  for (int round = 0; round < 200; ++round) {
+    std::vector<chartview::bucket> buckets;
+    for (int column = 0; column < width - 8; ++column) {
+      if (rng() % 3 == 0) {
+        continue;
+      }
+      const double low = ys(rng);
+      const double high = low + std::abs(ys(rng) - low) / 2;
+      buckets.push_back({.column = column,
+                         .first = low,
+                         .min = low,
+                         .max = high,
+                         .last = high,
+                         .mean = (low + high) / 2});
+    }
+    if (round % 10 == 0) {
+      buckets.resize(std::min<size_t>(buckets.size(), 1));
+    }
+    const int left = static_cast<int>(rng() % 8);
+
+    auto buffer = WhiteBuffer();
+    Rasterizer raster(buffer.data(), width, height);
+    raster.DrawBand(buckets, left, fill, line);
+
+    auto colourAt = [&](int x, int y) {
+      const size_t offset = ((static_cast<size_t>(y) * width) + x) * 3;
+      return std::array<unsigned char, 3>{buffer[offset], buffer[offset + 1],
+                                          buffer[offset + 2]};
+    };
+    auto is = [](const std::array<unsigned char, 3> &c, chartview::rgb rgb) {
+      return c[0] == rgb.r && c[1] == rgb.g && c[2] == rgb.b;
+    };
+    std::vector<const chartview::bucket *> byColumn(width, nullptr);
+    for (const auto &b : buckets) {
+      byColumn[left + b.column] = &b;
+    }
+    for (int x = 0; x < width; ++x) {
+      const auto *b = byColumn[x];
+      if (b != nullptr) {
+        const int mean = static_cast<int>(std::lround(b->mean));
+        if (mean >= 0 && mean < height && !is(colourAt(x, mean), line)) {
+          Fail(std::format("Rasterizer band round {}: mean of column {} "
+                           "not on the line",
+                           round, x));
+        }
+      }
+      for (int y = 0; y < height; ++y) {
+        const auto colour = colourAt(x, y);
+        const bool filled = b != nullptr && y >= std::lround(b->min) &&
+                            y <= std::lround(b->max);
+        if (!is(colour, line) &&
+            !(filled ? is(colour, fill) : colour[0] == 255)) {
+          Fail(std::format("Rasterizer band round {}: {}, {} wrongly {}",
+                           round, x, y, filled ? "unfilled" : "drawn"));
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+void TestRasterizer(std::mt19937 &rng) {
+  TestRasterizerLines(rng);
+  TestRasterizerSpans(rng);
+  TestRasterizerHeatmap(rng);
+  TestRasterizerBand(rng);
+}
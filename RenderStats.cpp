@@ -0,0 +1,130 @@
+#include "RenderStats.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+namespace {
+double ElapsedMs(std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+} // namespace
+
+RenderStats::RenderStats(size_t window)
+    : m_window(std::max<size_t>(window, 1)), m_next(), m_pointsIn(0),
+      m_pointsOut(0), m_allocations(0) {
+  for (auto &samples : m_samples) {
+    samples.reserve(m_window);
+  }
+}
+
+void RenderStats::Record(chartview::renderstage stage, double ms) {
+  const auto idx = static_cast<size_t>(stage);
+  auto &samples = m_samples.at(idx);
+
+  if (samples.size() < m_window) {
+    samples.push_back(ms);
+    return;
+  }
+
+  samples[m_next[idx]] = ms;
+  m_next[idx] = (m_next[idx] + 1) % m_window;
+}
+
+void RenderStats::RecordPoints(size_t pointsIn, size_t pointsOut) {
+  m_pointsIn = pointsIn;
+  m_pointsOut = pointsOut;
+}
+
+void RenderStats::RecordAllocations(size_t allocations) {
+  m_allocations = allocations;
+}
+
+void RenderStats::Reset() {
+  for (auto &samples : m_samples) {
+    samples.clear();
+  }
+  m_next.fill(0);
+  m_pointsIn = 0;
+  m_pointsOut = 0;
+  m_allocations = 0;
+}
+
+chartview::stagestats
+RenderStats::GetStage(chartview::renderstage stage) const {
+  const auto &samples = m_samples.at(static_cast<size_t>(stage));
+  if (samples.empty()) {
+    return {.minMs = 0, .avgMs = 0, .p99Ms = 0, .samples = 0};
+  }
+
+  std::vector<double> sorted = samples;
+  const auto p99Idx = std::min(sorted.size() - 1, (sorted.size() * 99) / 100);
+  std::ranges::nth_element(sorted, sorted.begin() + p99Idx);
+
+  const double sum = std::accumulate(samples.begin(), samples.end(), 0.0);
+
+  return {.minMs = std::ranges::min(samples),
+          .avgMs = sum / static_cast<double>(samples.size()),
+          .p99Ms = sorted[p99Idx],
+          .samples = samples.size()};
+}
+
+chartview::renderstatistics RenderStats::GetStatistics() const {
+  chartview::renderstatistics stats{};
+  for (size_t i = 0; i < chartview::renderstageCount; ++i) {
+    stats.stages.at(i) = GetStage(static_cast<chartview::renderstage>(i));
+  }
+  stats.pointsIn = m_pointsIn;
+  stats.pointsOut = m_pointsOut;
+  stats.allocations = m_allocations;
+
+  return stats;
+}
+
+std::string_view RenderStats::StageName(chartview::renderstage stage) {
+  switch (stage) {
+  case chartview::renderstage::gcCreate:
+    return "gc create";
+  case chartview::renderstage::prepare:
+    return "prepare";
+  case chartview::renderstage::background:
+    return "background";
+  case chartview::renderstage::grid:
+    return "grid";
+  case chartview::renderstage::decimate:
+    return "decimate";
+  case chartview::renderstage::transform:
+    return "transform";
+  case chartview::renderstage::pathBuild:
+    return "path build";
+  case chartview::renderstage::drawPath:
+    return "draw path";
+  case chartview::renderstage::prefetch:
+    return "prefetch";
+  case chartview::renderstage::overlay:
+    return "overlay";
+  case chartview::renderstage::blit:
+    return "blit";
+  case chartview::renderstage::frame:
+    return "frame";
+  }
+
+  return "unknown";
+}
+
+ScopedStageTimer::ScopedStageTimer(RenderStats &stats,
+                                   chartview::renderstage stage)
+    : m_stats(stats), m_stage(stage),
+      m_start(std::chrono::steady_clock::now()) {
+}
+
+ScopedStageTimer::~ScopedStageTimer() {
+  m_stats.Record(m_stage, ElapsedMs(m_start, std::chrono::steady_clock::now()));
+}
+
+void ScopedStageTimer::Next(chartview::renderstage stage) {
+  const auto now = std::chrono::steady_clock::now();
+  m_stats.Record(m_stage, ElapsedMs(m_start, now));
+  m_stage = stage;
+  m_start = now;
+}
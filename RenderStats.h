@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace chartview {
+// Timed stages of a paint, in the order they run
+enum class renderstage : std::uint8_t {
+  gcCreate,
+  // Frame setup: arena rewind, data snapshot and axis sync
+  prepare,
+  background,
+  // Viewport ranges, ticks and grid lines
+  grid,
+  decimate,
+  transform,
+  pathBuild,
+  drawPath,
+  // Pan columns reduced ahead for the next frames
+  prefetch,
+  overlay,
+  blit,
+  frame,
+};
+constexpr size_t renderstageCount = 12;
+
+struct stagestats {
+  double minMs;
+  double avgMs;
+  double p99Ms;
+  size_t samples;
+};
+
+struct renderstatistics {
+  std::array<stagestats, renderstageCount> stages;
+  size_t pointsIn;
+  size_t pointsOut;
+  // Heap allocations by the renderer's frame arena in the last frame, zero
+  // once painting has reached a steady state
+  size_t allocations;
+};
+} // namespace chartview
+
+// Rolling timing statistics over the last N samples of each render stage.
+// Recording is a clock read and a ring buffer store, the percentile is only
+// computed when the statistics are read.
+class RenderStats {
+public:
+  explicit RenderStats(size_t window = 240);
+
+  void Record(chartview::renderstage stage, double ms);
+  void RecordPoints(size_t pointsIn, size_t pointsOut);
+  void RecordAllocations(size_t allocations);
+  void Reset();
+
+  [[nodiscard]] chartview::stagestats
+  GetStage(chartview::renderstage stage) const;
+  [[nodiscard]] chartview::renderstatistics GetStatistics() const;
+
+  static std::string_view StageName(chartview::renderstage stage);
+
+private:
+  size_t m_window;
+  std::array<std::vector<double>, chartview::renderstageCount> m_samples;
+  std::array<size_t, chartview::renderstageCount> m_next;
+  size_t m_pointsIn;
+  size_t m_pointsOut;
+  size_t m_allocations;
+};
+
+// Records the lifetime of the scope as one sample of a stage
+class ScopedStageTimer {
+public:
+  ScopedStageTimer(RenderStats &stats, chartview::renderstage stage);
+  ~ScopedStageTimer();
+
+  ScopedStageTimer(const ScopedStageTimer &) = delete;
+  ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+  ScopedStageTimer(ScopedStageTimer &&) = delete;
+  ScopedStageTimer &operator=(ScopedStageTimer &&) = delete;
+
+  // Record the elapsed time now and start timing the next stage
+  void Next(chartview::renderstage stage);
+
+private:
+  RenderStats &m_stats;
+  chartview::renderstage m_stage;
+  std::chrono::steady_clock::time_point m_start;
+};
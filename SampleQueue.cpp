@@ -0,0 +1,48 @@
+#include "SampleQueue.h"
+#include <utility>
+
+SampleQueue::SampleQueue() : m_head(nullptr) {}
+
+SampleQueue::~SampleQueue() {
+  node *current = m_head.exchange(nullptr, std::memory_order_acquire);
+  while (current != nullptr) {
+    delete std::exchange(current, current->next);
+  }
+}
+
+bool SampleQueue::Push(chartview::sampleblock block) {
+  auto *added = new node{.block = std::move(block), .next = nullptr};
+
+  // Release publishes the block to the consumer's acquire exchange
+  node *head = m_head.load(std::memory_order_relaxed);
+  do {
+    added->next = head;
+  } while (!m_head.compare_exchange_weak(head, added,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed));
+
+  return head == nullptr;
+}
+
+std::vector<chartview::sampleblock> SampleQueue::Drain() {
+  // Newest first, count while reversing into push order
+  node *current = m_head.exchange(nullptr, std::memory_order_acquire);
+  node *oldest = nullptr;
+  size_t count = 0;
+  while (current != nullptr) {
+    node *next = current->next;
+    current->next = oldest;
+    oldest = current;
+    current = next;
+    ++count;
+  }
+
+  std::vector<chartview::sampleblock> blocks;
+  blocks.reserve(count);
+  while (oldest != nullptr) {
+    blocks.push_back(std::move(oldest->block));
+    delete std::exchange(oldest, oldest->next);
+  }
+
+  return blocks;
+}
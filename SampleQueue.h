@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+namespace chartview {
+// Points written by one producer in one go. x are plain values or
+// nanosecond timestamps, as for the two SetPlotData overloads.
+struct sampleblock {
+  std::variant<std::vector<double>, std::vector<std::int64_t>> xs;
+  std::vector<double> ys;
+};
+} // namespace chartview
+
+// Multi producer, single consumer queue of sample blocks. Push links a node
+// onto a stack with one compare-exchange and never blocks, Drain takes the
+// whole stack with one exchange and reverses it into push order. Producers
+// therefore never wait for the consumer or for each other, whatever the
+// consumer is busy with.
+class SampleQueue {
+public:
+  SampleQueue();
+  ~SampleQueue();
+
+  SampleQueue(const SampleQueue &) = delete;
+  SampleQueue &operator=(const SampleQueue &) = delete;
+  SampleQueue(SampleQueue &&) = delete;
+  SampleQueue &operator=(SampleQueue &&) = delete;
+
+  // Safe from any thread. Returns true if the queue was empty, so only
+  // the first block after a drain needs to wake the consumer.
+  bool Push(chartview::sampleblock block);
+  // Consumer only. Blocks of one producer come out in the order pushed.
+  [[nodiscard]] std::vector<chartview::sampleblock> Drain();
+
+private:
+  struct node {
+    chartview::sampleblock block;
+    node *next;
+  };
+
+  std::atomic<node *> m_head;
+};
@@ -0,0 +1,138 @@
+#include "ChartViewTests.h"
+#include "SampleQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace {
+constexpr int producers = 4;
+
+// Producers pushing numbered blocks while the consumer drains: every block
+// comes out once, each producer's in the order pushed, and exactly one push
+// per drained batch reports the queue was empty
+void TestSampleQueueProducers(std::mt19937 &rng) {
+  for (int round = 0; round < 20; ++round) {
+    const int blocks = 500 + static_cast<int>(rng() % 2000);
+    SampleQueue queue;
+    std::atomic<int> wakeups = 0;
+    std::atomic<int> running = producers;
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < producers; ++producer) {
+      threads.emplace_back([&, producer]() {
+        for (int i = 0; i < blocks; ++i) {
+          const bool empty = queue.Push(
+              {.xs = std::vector<double>{static_cast<double>(producer)},
+               .ys = {static_cast<double>(i)}});
+          if (empty) {
+            ++wakeups;
+          }
+        }
+        --running;
+      });
+    }
+
+    std::vector<int> next(producers, 0);
+    int batches = 0;
+    auto drain = [&]() {
+      const auto batch = queue.Drain();
+      batches += batch.empty() ? 0 : 1;
+      for (const auto &block : batch) {
+        const auto producer =
+            static_cast<size_t>(std::get<std::vector<double>>(block.xs)[0]);
+        if (static_cast<int>(block.ys[0]) != next[producer]) {
+          Fail(std::format("SampleQueue round {}: block {} of producer {} "
+                           "came after {}",
+                           round, block.ys[0], producer, next[producer] - 1));
+        }
+        next[producer] = static_cast<int>(block.ys[0]) + 1;
+      }
+    };
+    while (running > 0) {
+      drain();
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    drain();
+
+    if (next != std::vector<int>(producers, blocks) || wakeups != batches) {
+      Fail(std::format("SampleQueue round {}: {} wakeups for {} batches, "
+                       "or blocks lost",
+                       round, wakeups.load(), batches));
+    }
+  }
+}
+
+// Producers feeding a renderer through PushPlotData while it drains: all
+// points appended, in order per producer. A block the series cannot take
+// is reported once the others are appended.
+void TestPlotDataProducers(std::mt19937 &rng) {
+  for (int round = 0; round < 10; ++round) {
+    const int blocks = 200 + static_cast<int>(rng() % 500);
+    ChartRenderer renderer;
+    static_cast<void>(renderer.SetPlotData(std::vector<std::int64_t>{0},
+                                           std::vector<double>{-1}));
+    std::atomic<int> running = producers;
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < producers; ++producer) {
+      threads.emplace_back([&, producer]() {
+        for (int i = 0; i < blocks; ++i) {
+          // Timestamps count the blocks, y tells the producer
+          static_cast<void>(renderer.PushPlotData(
+              {.xs = std::vector<std::int64_t>{i + 1, i + 1},
+               .ys = {static_cast<double>(producer),
+                      static_cast<double>(producer)}}));
+        }
+        --running;
+      });
+    }
+    size_t appended = 0;
+    while (running > 0) {
+      appended += renderer.DrainPlotData().value_or(0);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    appended += renderer.DrainPlotData().value_or(0);
+
+    std::vector<double> last(producers, 0);
+    const auto data = renderer.GetSeries();
+    const std::span<const chartview::point> points = data->points;
+    for (const auto &p : points.subspan(1)) {
+      auto &x = last[static_cast<size_t>(p.y)];
+      if (p.x < x) {
+        Fail(std::format("PushPlotData round {}: producer {} at {} after {}",
+                         round, p.y, p.x, x));
+      }
+      x = p.x;
+    }
+    const auto expected = static_cast<size_t>(2 * producers * blocks);
+    if (appended != expected || points.size() != expected + 1) {
+      Fail(std::format("PushPlotData round {}: {} points appended, {} held "
+                       "of {}",
+                       round, appended, points.size(), expected));
+    }
+
+    // Plain x pushed to a timestamp series
+    static_cast<void>(renderer.PushPlotData(
+        {.xs = std::vector<double>{1}, .ys = {0}}));
+    static_cast<void>(renderer.PushPlotData(
+        {.xs = std::vector<std::int64_t>{blocks + 1}, .ys = {0}}));
+    if (renderer.DrainPlotData() ||
+        renderer.GetSeries()->points.size() != expected + 2) {
+      Fail(std::format("PushPlotData round {}: plain x appended to "
+                       "timestamps",
+                       round));
+    }
+  }
+}
+} // namespace
+
+void TestSampleQueue(std::mt19937 &rng) {
+  TestSampleQueueProducers(rng);
+  TestPlotDataProducers(rng);
+}
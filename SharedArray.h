@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+
+// Growable array whose storage can be shared with readers on other
+// threads. Copies share the storage and see the elements that existed when
+// they were made, while the original keeps appending behind them: appends
+// write past every copy's end and growing beyond the capacity moves the
+// owner to new storage, leaving the old one to the copies that still hold
+// it. Only the owner may write, copies are for reading.
+//
+// Dropping elements at the front only moves the start, the next growth
+// copies the remaining elements alone, so a sliding window costs amortized
+// O(1) per element.
+template <typename T> class SharedArray {
+public:
+  [[nodiscard]] size_t size() const { return m_size; }
+  [[nodiscard]] bool empty() const { return m_size == 0; }
+
+  T &operator[](size_t i) { return data()[i]; }
+  const T &operator[](size_t i) const { return data()[i]; }
+  T &front() { return data()[0]; }
+  const T &front() const { return data()[0]; }
+  T &back() { return data()[m_size - 1]; }
+  const T &back() const { return data()[m_size - 1]; }
+  T *data() { return m_data.get() + m_offset; }
+  const T *data() const { return m_data.get() + m_offset; }
+
+  T *begin() { return data(); }
+  T *end() { return data() + m_size; }
+  const T *begin() const { return data(); }
+  const T *end() const { return data() + m_size; }
+
+  operator std::span<const T>() const { return {data(), m_size}; }
+
+  void reserve(size_t capacity) {
+    if (m_offset + capacity <= m_capacity) {
+      return;
+    }
+
+    // Doubling keeps appends amortized O(1), dropped elements are left
+    // behind
+    const size_t grown = std::max(capacity, 2 * m_size);
+    auto storage = std::make_shared_for_overwrite<T[]>(grown);
+    std::copy_n(data(), m_size, storage.get());
+    m_data = std::move(storage);
+    m_capacity = grown;
+    m_offset = 0;
+  }
+
+  // Grow only, shrinking would hand elements copies read back to the
+  // owner. New elements are left uninitialized for trivial types.
+  void resize(size_t size) {
+    reserve(size);
+    m_size = size;
+  }
+
+  void push_back(const T &value) {
+    reserve(m_size + 1);
+    data()[m_size++] = value;
+  }
+
+  // Remove the first count elements, copies keep seeing them
+  void erase_front(size_t count) {
+    count = std::min(count, m_size);
+    m_offset += count;
+    m_size -= count;
+  }
+
+  // Drops the storage instead of reusing it, copies may still read it
+  void clear() {
+    m_data.reset();
+    m_offset = 0;
+    m_size = 0;
+    m_capacity = 0;
+  }
+
+private:
+  std::shared_ptr<T[]> m_data;
+  // Start of the elements in the storage, moved by erase_front
+  size_t m_offset = 0;
+  size_t m_size = 0;
+  size_t m_capacity = 0;
+};
@@ -0,0 +1,40 @@
+#include "ChartViewTests.h"
+#include "SharedArray.h"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <format>
+#include <utility>
+#include <vector>
+
+// A sliding array and its copies compared with the elements they held,
+// dropping at the front and appending beyond the capacity
+void TestSharedArray(std::mt19937 &rng) {
+  SharedArray<int> array;
+  std::deque<int> model;
+  std::vector<std::pair<SharedArray<int>, std::vector<int>>> copies;
+  int next = 0;
+  for (int round = 0; round < 300; ++round) {
+    const size_t count = rng() % 100;
+    for (size_t i = 0; i < count; ++i) {
+      array.push_back(next);
+      model.push_back(next++);
+    }
+    const size_t dropped = rng() % (model.size() + 1);
+    array.erase_front(dropped);
+    model.erase(model.begin(),
+                model.begin() + static_cast<std::ptrdiff_t>(dropped));
+
+    if (!std::ranges::equal(array, model)) {
+      Fail(std::format("SharedArray round {}: elements differ", round));
+    }
+    for (const auto &[copy, held] : copies) {
+      if (!std::ranges::equal(copy, held)) {
+        Fail(std::format("SharedArray round {}: a copy changed", round));
+      }
+    }
+    if (round % 20 == 0) {
+      copies.emplace_back(array, std::vector<int>(model.begin(), model.end()));
+    }
+  }
+}
@@ -0,0 +1,40 @@
+#include "SlidingMinMax.h"
+#include <algorithm>
+
+void SlidingMinMax::Push(double value) {
+  // A value hidden behind a newer, smaller one can never be the minimum
+  // again, likewise for the maximum
+  while (!m_min.empty() && m_min.back().second >= value) {
+    m_min.pop_back();
+  }
+  while (!m_max.empty() && m_max.back().second <= value) {
+    m_max.pop_back();
+  }
+  m_min.emplace_back(m_back, value);
+  m_max.emplace_back(m_back, value);
+  ++m_back;
+}
+
+void SlidingMinMax::PopFront(size_t count) {
+  m_front = std::min(m_front + count, m_back);
+  while (!m_min.empty() && m_min.front().first < m_front) {
+    m_min.pop_front();
+  }
+  while (!m_max.empty() && m_max.front().first < m_front) {
+    m_max.pop_front();
+  }
+}
+
+void SlidingMinMax::Clear() {
+  m_min.clear();
+  m_max.clear();
+  m_front = 0;
+  m_back = 0;
+}
+
+std::optional<std::pair<double, double>> SlidingMinMax::Get() const {
+  if (m_min.empty()) {
+    return std::nullopt;
+  }
+  return std::pair{m_min.front().second, m_max.front().second};
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <utility>
+
+// Min and max over a window of values that grows at the back and shrinks
+// at the front. Each end keeps a monotonic deque of the values that can
+// still become the extent, so pushing and dropping are amortized O(1) and
+// reading the extent is O(1).
+class SlidingMinMax {
+public:
+  void Push(double value);
+  // Drop the oldest count values
+  void PopFront(size_t count);
+  void Clear();
+
+  [[nodiscard]] std::optional<std::pair<double, double>> Get() const;
+
+private:
+  // Candidates as (position, value), positions count every value pushed
+  std::deque<std::pair<size_t, double>> m_min;
+  std::deque<std::pair<size_t, double>> m_max;
+  size_t m_front = 0;
+  size_t m_back = 0;
+};
@@ -0,0 +1,35 @@
+#include "ChartViewTests.h"
+#include "SlidingMinMax.h"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <format>
+#include <utility>
+
+// Extent of a sliding window compared with a scan of the window
+void TestSlidingMinMax(std::mt19937 &rng) {
+  SlidingMinMax extent;
+  std::deque<double> window;
+  for (int round = 0; round < 2000; ++round) {
+    const size_t count = rng() % 10;
+    for (size_t i = 0; i < count; ++i) {
+      // Few distinct values, so equal ones are pushed and evicted
+      const double value = static_cast<double>(rng() % 16);
+      extent.Push(value);
+      window.push_back(value);
+    }
+    // At times more than the window holds
+    const size_t dropped = rng() % (window.size() / 2 + 2);
+    extent.PopFront(dropped);
+    const auto erased =
+        static_cast<std::ptrdiff_t>(std::min(dropped, window.size()));
+    window.erase(window.begin(), window.begin() + erased);
+
+    const auto got = extent.Get();
+    if (window.empty() ? got.has_value()
+                       : got != std::pair{std::ranges::min(window),
+                                          std::ranges::max(window)}) {
+      Fail(std::format("SlidingMinMax round {}: extent differs", round));
+    }
+  }
+}
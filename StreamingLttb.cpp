@@ -0,0 +1,185 @@
+#include "StreamingLttb.h"
+#include "ChartRenderer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+// Zooming and panning by pixels round the viewport width a little
+// differently every time, widths this close continue the chain
+constexpr double widthTolerance = 1e-9;
+// Keys stay exact integers well below this, x farther out in bucket widths
+// is not followed
+constexpr double keyLimit = 1e15;
+} // namespace
+
+bool StreamingLttb::Update(const chartview::series &data, size_t first,
+                           size_t last, double xLow, double xHigh,
+                           int columns) {
+  m_reduced = 0;
+  if (!data.xSorted || columns <= 0 || !(xHigh > xLow) || first >= last) {
+    Clear();
+    return false;
+  }
+
+  const double width = (xHigh - xLow) / (2.0 * columns);
+  if (std::abs(xLow / width) > keyLimit || std::abs(xHigh / width) > keyLimit) {
+    Clear();
+    return false;
+  }
+
+  const size_t begin = data.evicted + first;
+  const size_t end = data.evicted + last;
+  // The open buckets are read again, their points must still be held
+  const bool follows =
+      !m_decided.empty() && data.generation == m_generation &&
+      std::abs(width - m_width) <= widthTolerance * width &&
+      begin >= m_chainBegin && begin < m_chainEnd && end >= m_chainEnd &&
+      (m_open.empty() || m_open.front().begin >= data.evicted);
+  if (!follows) {
+    Clear();
+    m_generation = data.generation;
+    m_width = width;
+    m_chainBegin = begin;
+    m_chainEnd = begin;
+  }
+  m_begin = begin;
+  m_end = end;
+
+  Follow(data, m_chainEnd, end);
+  m_reduced = end - m_chainEnd;
+  m_chainEnd = end;
+
+  // The open buckets are picked as if the last point ended the series
+  m_tail.clear();
+  if (!m_open.empty()) {
+    const auto &points = data.points;
+    const chartview::point &lastPoint = points[m_chainEnd - 1 - data.evicted];
+    pick previous = m_decided.back();
+    if (m_open.size() == 2) {
+      const auto &next = m_open.back();
+      const auto count = static_cast<double>(next.end - next.begin);
+      previous = Pick(data, m_open.front(), 0, previous, next.sumX / count,
+                      next.sumY / count);
+      m_tail.push_back(previous);
+    }
+    const auto &b = m_open.back();
+    if (b.end - b.begin > 1) {
+      m_tail.push_back(Pick(data, b, 1, previous, lastPoint.x, lastPoint.y));
+    }
+    m_tail.push_back({.position = m_chainEnd - 1,
+                      .key = b.key,
+                      .x = lastPoint.x,
+                      .y = lastPoint.y});
+  }
+
+  // Picks scrolled out by more than a view width, but never the last one
+  // before the view
+  const std::int64_t limit = KeyOf(xLow) - (2 * std::int64_t{columns});
+  while (m_decided.size() > 1 && m_decided[1].position < begin &&
+         m_decided[1].key < limit) {
+    m_decided.pop_front();
+    // Views starting at or before the dropped picks need them
+    m_chainBegin = m_decided.front().position + 1;
+  }
+
+  return true;
+}
+
+void StreamingLttb::Clear() {
+  m_decided.clear();
+  m_open.clear();
+  m_tail.clear();
+  m_width = 0;
+}
+
+std::pmr::vector<chartview::point>
+StreamingLttb::Points(std::pmr::memory_resource *resource) const {
+  std::pmr::vector<chartview::point> out(resource);
+  out.reserve(m_decided.size() + m_tail.size());
+
+  auto it = std::ranges::lower_bound(m_decided, m_begin, {}, &pick::position);
+  if (it != m_decided.begin()) {
+    --it;
+  }
+  for (; it != m_decided.end(); ++it) {
+    out.push_back({.x = it->x, .y = it->y});
+  }
+  for (const auto &p : m_tail) {
+    out.push_back({.x = p.x, .y = p.y});
+  }
+  return out;
+}
+
+size_t StreamingLttb::GetReducedCount() const { return m_reduced; }
+
+std::int64_t StreamingLttb::KeyOf(double x) const {
+  // Neighbours drawn beyond the viewport may lie arbitrarily far out
+  return static_cast<std::int64_t>(
+      std::clamp(std::floor(x / m_width), -keyLimit, keyLimit));
+}
+
+void StreamingLttb::Follow(const chartview::series &data, size_t from,
+                           size_t to) {
+  const auto &points = data.points;
+  for (size_t position = from; position < to; ++position) {
+    const chartview::point &point = points[position - data.evicted];
+    const std::int64_t key = KeyOf(point.x);
+    if (m_decided.empty()) {
+      // The first point is always kept
+      m_decided.push_back(
+          {.position = position, .key = key, .x = point.x, .y = point.y});
+      continue;
+    }
+
+    if (!m_open.empty() && m_open.back().key == key) {
+      auto &b = m_open.back();
+      ++b.end;
+      b.sumX += point.x;
+      b.sumY += point.y;
+      continue;
+    }
+
+    if (m_open.size() == 2) {
+      // The successor is complete, decide the bucket before it
+      const auto &next = m_open.back();
+      const auto count = static_cast<double>(next.end - next.begin);
+      m_decided.push_back(Pick(data, m_open.front(), 0, m_decided.back(),
+                               next.sumX / count, next.sumY / count));
+      m_open.erase(m_open.begin());
+    }
+    m_open.push_back({.key = key,
+                      .begin = position,
+                      .end = position + 1,
+                      .sumX = point.x,
+                      .sumY = point.y});
+  }
+}
+
+StreamingLttb::pick StreamingLttb::Pick(const chartview::series &data,
+                                        const bucket &b, size_t withoutLast,
+                                        const pick &previous, double x,
+                                        double y) {
+  assert(b.end - b.begin > withoutLast && "picking from an empty bucket");
+
+  const auto &points = data.points;
+  const size_t from = b.begin - data.evicted;
+  const size_t to = b.end - withoutLast - data.evicted;
+  // Twice the triangle area, the factor does not change the maximum
+  double maxArea = -1;
+  size_t best = from;
+  for (size_t i = from; i < to; ++i) {
+    const double area =
+        std::abs(((previous.x - x) * (points[i].y - previous.y)) -
+                 ((previous.x - points[i].x) * (y - previous.y)));
+    if (area > maxArea) {
+      maxArea = area;
+      best = i;
+    }
+  }
+
+  return {.position = data.evicted + best,
+          .key = b.key,
+          .x = points[best].x,
+          .y = points[best].y};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace chartview {
+struct point;
+struct series;
+} // namespace chartview
+
+// Largest-Triangle-Three-Buckets over an append only series, kept from frame
+// to frame. Buckets are aligned to multiples of their width in x, as the
+// columns of DecimationCache, two per pixel column. The first point is kept
+// and each bucket's pick is the point spanning the largest triangle with
+// the pick before it and the average of the next bucket, as in
+// DecimateLttb. A bucket is decided once the bucket after its successor
+// has started, so Update only reads the points appended since the last
+// frame and the two buckets still open, and drops picks scrolled out by
+// more than a view width.
+//
+// The picks depend on every pick before them, so the chain of picks only
+// follows the view forward. A new bucket width (zoom, resize), series
+// generation or a view starting before the chain or beyond its end starts
+// over from the visible points.
+class StreamingLttb {
+public:
+  // Follow points [first, last) of data with buckets of width
+  // (xHigh - xLow) / (2 * columns). Returns false if the points cannot be
+  // followed (x not sorted, nothing visible), callers use DecimateLttb then.
+  bool Update(const chartview::series &data, size_t first, size_t last,
+              double xLow, double xHigh, int columns);
+  void Clear();
+
+  // Picks of the points given to the last Update, after the last one before
+  // them so the line enters the view, then picks of the open buckets and
+  // the last point
+  [[nodiscard]] std::pmr::vector<chartview::point>
+  Points(std::pmr::memory_resource *resource =
+             std::pmr::get_default_resource()) const;
+
+  // Points added to the chain by the last Update, the picks before them
+  // were decided by earlier ones
+  [[nodiscard]] size_t GetReducedCount() const;
+
+private:
+  // Points are identified by their position, the index they had before any
+  // were evicted, as in DecimationCache
+  struct pick {
+    size_t position;
+    std::int64_t key;
+    double x;
+    double y;
+  };
+  // Points [begin, end) of one bucket
+  struct bucket {
+    std::int64_t key;
+    size_t begin;
+    size_t end;
+    double sumX;
+    double sumY;
+  };
+
+  [[nodiscard]] std::int64_t KeyOf(double x) const;
+  // Add points at positions [from, to) to the open buckets, deciding the
+  // buckets they complete
+  void Follow(const chartview::series &data, size_t from, size_t to);
+  // The point of b, leaving out its last withoutLast points, spanning the
+  // largest triangle with previous and x, y
+  static pick Pick(const chartview::series &data, const bucket &b,
+                   size_t withoutLast, const pick &previous, double x,
+                   double y);
+
+  std::deque<pick> m_decided;
+  // The bucket waiting for its successor to complete, and that successor
+  std::vector<bucket> m_open;
+  // Picks of the open buckets and the last point, as of the last Update
+  std::vector<pick> m_tail;
+  double m_width = 0;
+  size_t m_generation = 0;
+  // Positions of the first point a view may start at, the picks before it
+  // were dropped, and after the last point read
+  size_t m_chainBegin = 0;
+  size_t m_chainEnd = 0;
+  // Positions of the points given to the last Update
+  size_t m_begin = 0;
+  size_t m_end = 0;
+  size_t m_reduced = 0;
+};
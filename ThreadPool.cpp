@@ -0,0 +1,49 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) : m_stopping(false) {
+  // hardware_concurrency may report 0 when it is unknown
+  threadCount = std::max(threadCount, 1U);
+
+  m_workers.reserve(threadCount);
+  for (unsigned i = 0; i < threadCount; ++i) {
+    m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stopping = true;
+  }
+  m_taskAvailable.notify_all();
+
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+}
+
+unsigned ThreadPool::GetThreadCount() const {
+  return static_cast<unsigned>(m_workers.size());
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(m_mutex);
+      m_taskAvailable.wait(lock,
+                           [this]() { return m_stopping || !m_tasks.empty(); });
+
+      // Drain remaining tasks before stopping so no future is left hanging
+      if (m_tasks.empty()) {
+        return;
+      }
+
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+
+    task();
+  }
+}
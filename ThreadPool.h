@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed size pool of worker threads consuming a FIFO task queue
+class ThreadPool {
+public:
+  explicit ThreadPool(
+      unsigned threadCount = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>> Submit(F &&task) {
+    using result_t = std::invoke_result_t<F>;
+
+    // packaged_task is move only, std::function needs a copyable target
+    auto packaged = std::make_shared<std::packaged_task<result_t()>>(
+        std::forward<F>(task));
+    auto future = packaged->get_future();
+    {
+      std::scoped_lock lock(m_mutex);
+      m_tasks.emplace_back([packaged]() { (*packaged)(); });
+    }
+    m_taskAvailable.notify_one();
+
+    return future;
+  }
+
+  [[nodiscard]] unsigned GetThreadCount() const;
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_taskAvailable;
+  std::deque<std::function<void()>> m_tasks;
+  bool m_stopping;
+
+  std::vector<std::thread> m_workers;
+
+  void WorkerLoop();
+};
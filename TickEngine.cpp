@@ -0,0 +1,341 @@
+#include "TickEngine.h"
+#include "ChartRenderer.h"
+#include "wx/graphics.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <limits>
+
+namespace {
+constexpr int maxTicks = 20;
+
+constexpr std::int64_t ns = 1;
+constexpr std::int64_t us = 1000 * ns;
+constexpr std::int64_t ms = 1000 * us;
+constexpr std::int64_t sec = 1000 * ms;
+constexpr std::int64_t minute = 60 * sec;
+constexpr std::int64_t hour = 60 * minute;
+constexpr std::int64_t day = 24 * hour;
+// 1970-01-01 was a Thursday, weeks start on Monday 1970-01-05
+constexpr std::int64_t mondayPhase = 4 * day;
+
+// Fixed length time steps, longer ranges step in calendar months
+constexpr std::array<std::int64_t, 39> timeSteps{
+    1 * ns,      2 * ns,      5 * ns,      10 * ns,     20 * ns,
+    50 * ns,     100 * ns,    200 * ns,    500 * ns,    1 * us,
+    2 * us,      5 * us,      10 * us,     20 * us,     50 * us,
+    100 * us,    200 * us,    500 * us,    1 * ms,      2 * ms,
+    5 * ms,      10 * ms,     20 * ms,     50 * ms,     100 * ms,
+    200 * ms,    500 * ms,    1 * sec,     2 * sec,     5 * sec,
+    10 * sec,    15 * sec,    30 * sec,    1 * minute,  5 * minute,
+    15 * minute, 1 * hour,    6 * hour,    1 * day};
+constexpr std::int64_t week = 7 * day;
+constexpr std::array<int, 10> monthSteps{1,  2,  3,   6,   12,
+                                         24, 60, 120, 240, 600};
+constexpr double monthLength = 30.436875 * day;
+
+std::int64_t FloorDiv(std::int64_t a, std::int64_t b) {
+  return (a / b) - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+}
+
+// Decimals needed to tell values step apart, steps like 0.25 need more than
+// their magnitude suggests
+int Decimals(double step) {
+  int decimals = 0;
+  for (double scaled = step;
+       decimals < 12 && std::abs(scaled - std::round(scaled)) > scaled * 1e-6;
+       scaled *= 10) {
+    ++decimals;
+  }
+  return decimals;
+}
+
+// Significant digits that tell value from its neighbours step away: the
+// decades between value and step, plus the decimals of step's mantissa
+// (2.5 needs one more than 2)
+int SignificantDigits(double value, double step) {
+  const double stepDecade = std::floor(std::log10(step));
+  const double valueDecade =
+      std::floor(std::log10(std::max(std::abs(value), step)));
+  const double digits = valueDecade - stepDecade + 1 +
+                        Decimals(step / std::pow(10.0, stepDecade));
+  return static_cast<int>(std::clamp(digits, 1.0, 17.0));
+}
+
+// Format value with just enough decimals to tell ticks step apart
+std::string_view FormatTick(std::array<char, 32> &buffer, double value,
+                            double step, chartview::axisformat format) {
+  // Snap values like 1e-17 that should be zero, avoids printing -0
+  if (std::abs(value) < step * 1e-9) {
+    value = 0;
+  }
+
+  char *end = nullptr;
+  if (format == chartview::axisformat::seconds) {
+    // Largest unit the step is at least one of
+    struct unit {
+      double scale;
+      const char *suffix;
+    };
+    constexpr std::array<unit, 4> units{{{.scale = 1, .suffix = "s"},
+                                         {.scale = 1e-3, .suffix = "ms"},
+                                         {.scale = 1e-6, .suffix = "us"},
+                                         {.scale = 1e-9, .suffix = "ns"}}};
+    auto it = std::ranges::find_if(
+        units, [step](const unit &u) { return step >= u.scale * 0.999; });
+    const unit &u = it != units.end() ? *it : units.back();
+
+    end = std::format_to_n(buffer.data(), buffer.size(), "{:.{}f} {}",
+                           value / u.scale, Decimals(step / u.scale),
+                           u.suffix)
+              .out;
+  } else if (std::max(std::abs(value), step) >= 1e7 || step < 1e-5) {
+    end = std::format_to_n(buffer.data(), buffer.size(), "{:.{}g}", value,
+                           SignificantDigits(value, step))
+              .out;
+  } else {
+    end = std::format_to_n(buffer.data(), buffer.size(), "{:.{}f}", value,
+                           Decimals(step))
+              .out;
+  }
+  return {buffer.data(), static_cast<size_t>(end - buffer.data())};
+}
+
+// Format the UTC time t (ns since epoch) with the precision step needs.
+// Ticks at midnight of sub day steps show the date instead of 00:00.
+std::string_view FormatTime(std::array<char, 32> &buffer, std::int64_t t,
+                            std::int64_t step, bool monthly) {
+  namespace chrono = std::chrono;
+
+  const chrono::sys_time<chrono::nanoseconds> time{chrono::nanoseconds{t}};
+  const auto date = chrono::floor<chrono::days>(time);
+  const chrono::year_month_day ymd{date};
+  const chrono::hh_mm_ss hms{time - date};
+
+  const int y = static_cast<int>(ymd.year());
+  const auto mo = static_cast<unsigned>(ymd.month());
+  const auto d = static_cast<unsigned>(ymd.day());
+  const auto h = hms.hours().count();
+  const auto mi = hms.minutes().count();
+  const auto s = hms.seconds().count();
+  const auto sub = hms.subseconds().count();
+
+  const auto n = buffer.size();
+  char *out = buffer.data();
+  char *end = nullptr;
+  if (monthly && step >= 12) {
+    end = std::format_to_n(out, n, "{}", y).out;
+  } else if (monthly) {
+    end = std::format_to_n(out, n, "{}-{:02}", y, mo).out;
+  } else if (step >= day || time == date) {
+    end = std::format_to_n(out, n, "{}-{:02}-{:02}", y, mo, d).out;
+  } else if (step >= minute) {
+    end = std::format_to_n(out, n, "{:02}:{:02}", h, mi).out;
+  } else if (step >= sec) {
+    end = std::format_to_n(out, n, "{:02}:{:02}:{:02}", h, mi, s).out;
+  } else if (step >= ms) {
+    end = std::format_to_n(out, n, "{:02}:{:02}.{:03}", mi, s, sub / ms).out;
+  } else if (step >= us) {
+    end = std::format_to_n(out, n, "{:02}.{:06}", s, sub / us).out;
+  } else {
+    end = std::format_to_n(out, n, "{:02}.{:09}", s, sub).out;
+  }
+  return {buffer.data(), static_cast<size_t>(end - buffer.data())};
+}
+} // namespace
+
+TickEngine::TickEngine(double minSpacing)
+    : m_minSpacing(minSpacing), m_format(chartview::axisformat::number),
+      m_timeOrigin(0), m_valid(false), m_low(0), m_high(0), m_length(0),
+      m_ticks(), m_computeCount(0) {}
+
+void TickEngine::SetFormat(chartview::axisformat format) {
+  if (format != m_format) {
+    m_format = format;
+    m_valid = false;
+  }
+}
+
+chartview::axisformat TickEngine::GetFormat() const {
+  return m_format;
+}
+
+void TickEngine::SetTimeOrigin(std::int64_t origin) {
+  if (origin != m_timeOrigin) {
+    m_timeOrigin = origin;
+    m_valid = false;
+  }
+}
+
+const chartview::axisticks &TickEngine::Ticks(double low, double high,
+                                              double length) {
+  if (m_valid && low == m_low && high == m_high && length == m_length) {
+    return m_ticks;
+  }
+
+  m_valid = true;
+  m_low = low;
+  m_high = high;
+  m_length = length;
+  ++m_computeCount;
+
+  m_ticks.values.clear();
+  m_ticks.measured = false;
+  if (!(low < high) || !(length > 0)) {
+    m_ticks.labels.clear();
+    return m_ticks;
+  }
+
+  const int count =
+      std::clamp(static_cast<int>(length / m_minSpacing), 2, maxTicks);
+  if (m_format == chartview::axisformat::timestamp) {
+    TimeTicks(low, high, count);
+  } else {
+    NumberTicks(low, high, count);
+  }
+
+  return m_ticks;
+}
+
+void TickEngine::NumberTicks(double low, double high, int maxCount) {
+  auto [segs, niceLow, niceHigh] =
+      ChartRenderer::NiceLabels(low, high, maxCount);
+  if (segs < 1) {
+    m_ticks.labels.clear();
+    return;
+  }
+
+  const double step = (niceHigh - niceLow) / segs;
+  const double eps = step * 1e-9;
+  for (int i = 0; i <= segs; ++i) {
+    const double tick = niceLow + (i * step);
+    if (tick >= low - eps && tick <= high + eps) {
+      m_ticks.values.push_back(tick);
+    }
+  }
+
+  // Resize rather than clear, assigning keeps the strings' capacity
+  m_ticks.labels.resize(m_ticks.values.size());
+  std::array<char, 32> buffer{};
+  for (size_t i = 0; i < m_ticks.values.size(); ++i) {
+    m_ticks.labels[i].assign(
+        FormatTick(buffer, m_ticks.values[i], step, m_format));
+  }
+}
+
+void TickEngine::TimeTicks(double low, double high, int maxCount) {
+  namespace chrono = std::chrono;
+
+  // Tick times are nanoseconds since the epoch in int64, which reaches
+  // about 292 years either side of 1970. Ranges the origin plus offset
+  // would overflow at, less a week kept for stepping past the ends, get
+  // no ticks.
+  constexpr std::int64_t int64Min = std::numeric_limits<std::int64_t>::min();
+  constexpr std::int64_t int64Max = std::numeric_limits<std::int64_t>::max();
+  const std::int64_t lowest =
+      (m_timeOrigin > 0 ? int64Min : int64Min - m_timeOrigin) + week;
+  const std::int64_t highest =
+      (m_timeOrigin < 0 ? int64Max : int64Max - m_timeOrigin) - week;
+  const double lowOffset = std::ceil(low * 1e9);
+  const double highOffset = std::floor(high * 1e9);
+  if (!(lowOffset >= static_cast<double>(lowest)) ||
+      !(highOffset <= static_cast<double>(highest))) {
+    m_ticks.labels.clear();
+    return;
+  }
+
+  // Tick times are exact integers, only the offsets from the origin that
+  // are drawn are doubles
+  const std::int64_t lowNs = m_timeOrigin + std::llround(lowOffset);
+  const std::int64_t highNs = m_timeOrigin + std::llround(highOffset);
+  const double rawStep = (high - low) * 1e9 / maxCount;
+
+  std::array<std::int64_t, maxTicks + 1> times{};
+  size_t count = 0;
+  std::int64_t step = 0;
+  bool monthly = false;
+
+  const auto fixed = std::ranges::find_if(
+      timeSteps, [rawStep](std::int64_t s) { return s >= rawStep; });
+  if (fixed != timeSteps.end() || rawStep <= week) {
+    // Fixed length steps aligned to the epoch, weeks start on Monday
+    step = fixed != timeSteps.end() ? *fixed : week;
+    const std::int64_t phase = step == week ? mondayPhase : 0;
+    const std::int64_t first =
+        ((FloorDiv(lowNs - phase - 1, step) + 1) * step) + phase;
+    for (std::int64_t t = first; t <= highNs && count < times.size();
+         t += step) {
+      times.at(count++) = t;
+    }
+  } else {
+    // Whole months, aligned to multiples of the step since year 0
+    monthly = true;
+    const auto months = std::ranges::find_if(
+        monthSteps, [rawStep](int m) { return m * monthLength >= rawStep; });
+    step = months != monthSteps.end() ? *months : monthSteps.back();
+
+    // Months are compared as days first, the first ones may lie before
+    // the nanoseconds reach back
+    const auto lowDays = chrono::floor<chrono::days>(
+        chrono::sys_time<chrono::nanoseconds>{chrono::nanoseconds{lowNs}});
+    const auto highDays = chrono::floor<chrono::days>(
+        chrono::sys_time<chrono::nanoseconds>{chrono::nanoseconds{highNs}});
+    const chrono::year_month_day lowDate{lowDays};
+    const std::int64_t lowIndex =
+        (static_cast<std::int64_t>(static_cast<int>(lowDate.year())) * 12) +
+        static_cast<unsigned>(lowDate.month()) - 1;
+    for (std::int64_t index = FloorDiv(lowIndex, step) * step;
+         count < times.size(); index += step) {
+      const std::int64_t y = FloorDiv(index, 12);
+      const chrono::year_month_day date{
+          chrono::year{static_cast<int>(y)},
+          chrono::month{static_cast<unsigned>(index - (y * 12) + 1)},
+          chrono::day{1}};
+      const chrono::sys_days start{date};
+      if (start > highDays) {
+        break;
+      }
+      if (start < lowDays) {
+        continue;
+      }
+      const std::int64_t t = chrono::duration_cast<chrono::nanoseconds>(
+                                 start.time_since_epoch())
+                                 .count();
+      if (t >= lowNs) {
+        times.at(count++) = t;
+      }
+    }
+  }
+
+  m_ticks.labels.resize(count);
+  std::array<char, 32> buffer{};
+  for (size_t i = 0; i < count; ++i) {
+    m_ticks.values.push_back(static_cast<double>(times.at(i) - m_timeOrigin) *
+                             1e-9);
+    m_ticks.labels[i].assign(FormatTime(buffer, times.at(i), step, monthly));
+  }
+}
+
+const chartview::axisticks &TickEngine::Measure(wxGraphicsContext &gc) {
+  if (m_ticks.measured) {
+    return m_ticks;
+  }
+
+  m_ticks.widths.resize(m_ticks.labels.size());
+  m_ticks.height = 0;
+  for (size_t i = 0; i < m_ticks.labels.size(); ++i) {
+    double height = 0;
+    gc.GetTextExtent(m_ticks.labels[i], &m_ticks.widths[i], &height);
+    m_ticks.height = std::max(m_ticks.height, height);
+  }
+  m_ticks.measured = true;
+
+  return m_ticks;
+}
+
+size_t TickEngine::GetComputeCount() const {
+  return m_computeCount;
+}
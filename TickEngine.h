@@ -0,0 +1,68 @@
+#pragma once
+
+#include "wx/graphics.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace chartview {
+// How tick labels are written. seconds treats values as seconds and picks
+// s, ms, us or ns from the tick step, e.g. "250 ms" rather than "0.25".
+// timestamp treats values as seconds after the engine's time origin and
+// places ticks on calendar boundaries (whole minutes, days, months, ...) in
+// UTC, labelled as dates and times.
+enum class axisformat : std::uint8_t { number, seconds, timestamp };
+
+// Tick positions and formatted labels of one axis
+struct axisticks {
+  std::vector<double> values;
+  std::vector<std::string> labels;
+  // Label text extents, filled in by TickEngine::Measure
+  std::vector<double> widths;
+  double height;
+  bool measured;
+};
+} // namespace chartview
+
+// Nice number ticks for one axis. The result is memoized on the axis range
+// and pixel length and label extents are measured once per result, so
+// repainting an unchanged axis does no formatting or font measurement.
+// Vectors and label strings are reused, recomputing does not allocate once
+// they have grown to the largest tick count.
+class TickEngine {
+public:
+  // minSpacing is the smallest pixel distance between two ticks
+  explicit TickEngine(double minSpacing);
+
+  void SetFormat(chartview::axisformat format);
+  [[nodiscard]] chartview::axisformat GetFormat() const;
+  // Nanoseconds since the epoch that value 0 stands for in timestamp format
+  void SetTimeOrigin(std::int64_t origin);
+
+  // Ticks inside [low, high] for an axis drawn over length pixels
+  const chartview::axisticks &Ticks(double low, double high, double length);
+  // Measure the labels of the last result with the font set on gc. The
+  // renderer draws all labels in one font, so extents are only measured
+  // again when the ticks change.
+  const chartview::axisticks &Measure(wxGraphicsContext &gc);
+
+  // Number of times ticks were actually computed, not taken from the memo
+  [[nodiscard]] size_t GetComputeCount() const;
+
+private:
+  double m_minSpacing;
+  chartview::axisformat m_format;
+  std::int64_t m_timeOrigin;
+
+  bool m_valid;
+  double m_low;
+  double m_high;
+  double m_length;
+  chartview::axisticks m_ticks;
+  size_t m_computeCount;
+
+  // Fill m_ticks with at most maxCount ticks inside [low, high]
+  void NumberTicks(double low, double high, int maxCount);
+  void TimeTicks(double low, double high, int maxCount);
+};
@@ -0,0 +1,183 @@
+#include "ChartViewTests.h"
+#include "TickEngine.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+// Ticks inside [low, high], ascending, and labels that all differ unless
+// repeats are allowed
+void CheckTicks(const chartview::axisticks &ticks, double low, double high,
+                std::string_view what, bool repeats = false) {
+  const double eps = (high - low) * 1e-9;
+  for (size_t i = 0; i < ticks.values.size(); ++i) {
+    if (ticks.values[i] < low - eps || ticks.values[i] > high + eps ||
+        (i > 0 && ticks.values[i] <= ticks.values[i - 1])) {
+      Fail(std::format("{}: tick {} of [{}, {}] out of place", what,
+                       ticks.values[i], low, high));
+    }
+  }
+  if (ticks.labels.size() != ticks.values.size() ||
+      (!repeats &&
+       std::set<std::string>(ticks.labels.begin(), ticks.labels.end())
+               .size() != ticks.labels.size())) {
+    Fail(std::format("{}: {} labels for {} ticks of [{}, {}] are not all "
+                     "different, first {}",
+                     what, ticks.labels.size(), ticks.values.size(), low,
+                     high, ticks.labels.empty() ? "" : ticks.labels.front()));
+  }
+}
+
+// Number ticks of ranges from tiny to huge, zoomed in far from zero too:
+// evenly spaced, and labels that read back as their values
+void TestNumberTicks(std::mt19937 &rng) {
+  TickEngine engine(40);
+  std::uniform_real_distribution<double> unit(-1, 1);
+  for (int round = 0; round < 2000; ++round) {
+    const double centre = unit(rng) * std::pow(10.0, (rng() % 30) - 12.0);
+    const double width =
+        std::abs(centre) * std::pow(10.0, -static_cast<double>(rng() % 12)) +
+        std::pow(10.0, (rng() % 20) - 10.0);
+    const double low = centre - (width * (0.5 + unit(rng) / 4));
+    const double high = low + width;
+    const double length = 50 + static_cast<double>(rng() % 1000);
+    const auto &ticks = engine.Ticks(low, high, length);
+    const auto what = std::format("number ticks round {}", round);
+    CheckTicks(ticks, low, high, what);
+    if (ticks.values.empty()) {
+      Fail(std::format("{}: no ticks for [{}, {}]", what, low, high));
+      continue;
+    }
+
+    // Spacing up to the rounding of values far from zero
+    const double step = ticks.values.size() > 1
+                            ? ticks.values[1] - ticks.values[0]
+                            : high - low;
+    const double eps = (step * 1e-6) + (std::abs(centre) * 1e-14);
+    for (size_t i = 0; i < ticks.values.size(); ++i) {
+      if (i > 0 &&
+          std::abs(ticks.values[i] - ticks.values[i - 1] - step) > eps) {
+        Fail(std::format("{}: uneven step at tick {}", what, i));
+      }
+      if (std::abs(std::stod(ticks.labels[i]) - ticks.values[i]) >
+          step * 0.5) {
+        Fail(std::format("{}: label {} of tick {}", what, ticks.labels[i],
+                         ticks.values[i]));
+      }
+    }
+
+    // Memoized while the axis is unchanged
+    const size_t computed = engine.GetComputeCount();
+    static_cast<void>(engine.Ticks(low, high, length));
+    if (engine.GetComputeCount() != computed) {
+      Fail(std::format("{}: unchanged axis computed again", what));
+    }
+  }
+}
+
+// Seconds ticks from nanoseconds to hours: labels in the largest unit the
+// step is at least one of, reading back as their values
+void TestSecondsTicks(std::mt19937 &rng) {
+  struct unit {
+    std::string_view suffix;
+    double scale;
+  };
+  constexpr std::array<unit, 4> units{{{.suffix = "s", .scale = 1},
+                                       {.suffix = "ms", .scale = 1e-3},
+                                       {.suffix = "us", .scale = 1e-6},
+                                       {.suffix = "ns", .scale = 1e-9}}};
+
+  TickEngine engine(40);
+  engine.SetFormat(chartview::axisformat::seconds);
+  std::uniform_real_distribution<double> unitRange(-1, 1);
+  for (int round = 0; round < 1000; ++round) {
+    const double width = std::pow(10.0, unitRange(rng) * 6 - 3);
+    const double low = unitRange(rng) * width * 10;
+    const double high = low + width;
+    const auto &ticks = engine.Ticks(low, high, 300);
+    const auto what = std::format("seconds ticks round {}", round);
+    CheckTicks(ticks, low, high, what);
+    if (ticks.values.size() < 2) {
+      Fail(std::format("{}: {} ticks for [{}, {}]", what, ticks.values.size(),
+                       low, high));
+      continue;
+    }
+
+    const double step = ticks.values[1] - ticks.values[0];
+    const auto expected = std::ranges::find_if(
+        units, [step](const unit &u) { return step >= u.scale * 0.999; });
+    const unit &u = expected != units.end() ? *expected : units.back();
+    for (size_t i = 0; i < ticks.values.size(); ++i) {
+      const std::string_view label = ticks.labels[i];
+      const auto space = label.find(' ');
+      if (space == std::string_view::npos ||
+          label.substr(space + 1) != u.suffix ||
+          std::abs((std::stod(std::string(label.substr(0, space))) *
+                    u.scale) -
+                   ticks.values[i]) > step * 0.5) {
+        Fail(std::format("{}: label {} of tick {} with step {}", what, label,
+                         ticks.values[i], step));
+      }
+    }
+  }
+}
+
+// Timestamp ticks of ranges from nanoseconds to centuries around origins
+// anywhere in the int64 nanoseconds, up to and past the ends of it
+void TestTimestampTicks(std::mt19937 &rng) {
+  constexpr double nsLimit = 9.2e18;
+  TickEngine engine(40);
+  engine.SetFormat(chartview::axisformat::timestamp);
+  std::uniform_real_distribution<double> unit(-1, 1);
+  for (int round = 0; round < 2000; ++round) {
+    const auto origin = static_cast<std::int64_t>(unit(rng) * nsLimit);
+    double width = std::pow(10.0, (unit(rng) * 9.5) + 0.5);
+    const double low =
+        round % 2 == 0 ? unit(rng) * width : unit(rng) * nsLimit * 2e-9;
+    // Offsets are doubles, far from the origin they cannot tell nanoseconds
+    // apart
+    width = std::max(width, std::abs(low) * 1e-11);
+    const double high = low + width;
+    engine.SetTimeOrigin(origin);
+    const auto &ticks = engine.Ticks(low, high, 50 + (rng() % 1000));
+    const auto what = std::format("timestamp ticks round {}", round);
+    // Times of day repeat on every day, the date is shown at midnight
+    CheckTicks(ticks, low, high, what, true);
+
+    // Times past the ends of int64 get no ticks
+    const double first = static_cast<double>(origin) + (low * 1e9);
+    const double last = static_cast<double>(origin) + (high * 1e9);
+    const auto end =
+        static_cast<double>(std::numeric_limits<std::int64_t>::max());
+    if (!ticks.values.empty() && (first < -end || last > end)) {
+      Fail(std::format("{}: ticks beyond int64 nanoseconds, [{}, {}] from "
+                       "origin {}",
+                       what, low, high, origin));
+    }
+  }
+
+  // A day of 2021-03-14 UTC from an hour before midnight, the date shown
+  // at midnight
+  engine.SetTimeOrigin(1615680000LL * 1000000000);
+  const auto &day = engine.Ticks(-3600, 86400 - 3600, 800);
+  const std::vector<std::string> expected{"2021-03-14", "06:00", "12:00",
+                                          "18:00"};
+  if (day.labels != expected || day.values.front() != 0) {
+    Fail(std::format("timestamp ticks: a day labelled {}",
+                     day.labels.empty() ? "" : day.labels.front()));
+  }
+}
+} // namespace
+
+void TestTickEngine(std::mt19937 &rng) {
+  TestNumberTicks(rng);
+  TestSecondsTicks(rng);
+  TestTimestampTicks(rng);
+}
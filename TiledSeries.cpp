@@ -0,0 +1,459 @@
+#include "TiledSeries.h"
+#include "ChartRenderer.h"
+#include "Decimation.h"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <tuple>
+
+namespace {
+struct indexheader {
+  std::array<char, 4> magic;
+  std::uint32_t version;
+  std::uint64_t chunkPoints;
+};
+
+constexpr std::array<char, 4> indexMagic{'C', 'V', 'T', 'S'};
+constexpr std::uint32_t indexVersion = 1;
+
+std::filesystem::path IndexPath(const std::filesystem::path &path) {
+  auto index = path;
+  index += ".idx";
+  return index;
+}
+} // namespace
+
+TiledSeries::TiledSeries(std::filesystem::path path, size_t chunkPoints)
+    : m_path(std::move(path)), m_chunkPoints(chunkPoints) {}
+
+TiledSeries::~TiledSeries() = default;
+
+tl::expected<std::unique_ptr<TiledSeries>, std::string>
+TiledSeries::Create(const std::filesystem::path &path, size_t chunkPoints) {
+  if (chunkPoints == 0) {
+    return tl::make_unexpected(
+        std::string("plot error: archive chunks need at least one point"));
+  }
+
+  std::unique_ptr<TiledSeries> series(new TiledSeries(path, chunkPoints));
+  constexpr auto mode = std::ios::in | std::ios::out | std::ios::binary |
+                        std::ios::trunc;
+  series->m_data.open(path, mode);
+  series->m_index.open(IndexPath(path), mode);
+
+  const indexheader header{.magic = indexMagic,
+                           .version = indexVersion,
+                           .chunkPoints = chunkPoints};
+  series->m_index.write(reinterpret_cast<const char *>(&header),
+                        sizeof(header));
+  if (!series->m_data || !series->m_index.flush()) {
+    return tl::make_unexpected(
+        std::format("plot error: cannot create archive {}", path.string()));
+  }
+
+  return series;
+}
+
+tl::expected<std::unique_ptr<TiledSeries>, std::string>
+TiledSeries::Open(const std::filesystem::path &path) {
+  std::fstream index(IndexPath(path),
+                     std::ios::in | std::ios::out | std::ios::binary);
+  indexheader header{};
+  index.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!index || header.magic != indexMagic ||
+      header.version != indexVersion || header.chunkPoints == 0) {
+    return tl::make_unexpected(
+        std::format("plot error: {} is not an archive index",
+                    IndexPath(path).string()));
+  }
+
+  std::unique_ptr<TiledSeries> series(
+      new TiledSeries(path, header.chunkPoints));
+  summary s{};
+  while (index.read(reinterpret_cast<char *>(&s), sizeof(s))) {
+    series->m_summaries.push_back(s);
+    series->m_pointCount += s.count;
+  }
+  index.clear();
+  series->m_index = std::move(index);
+  series->UpdatePyramid(0);
+
+  if (!series->m_summaries.empty()) {
+    auto &[yMin, yMax] = series->m_yExtent;
+    yMin = series->m_summaries.front().yMin;
+    yMax = series->m_summaries.front().yMax;
+    for (const auto &c : series->m_summaries) {
+      yMin = std::min(yMin, c.yMin);
+      yMax = std::max(yMax, c.yMax);
+    }
+  }
+
+  series->m_data.open(path, std::ios::in | std::ios::out | std::ios::binary);
+  std::error_code error;
+  const auto size = std::filesystem::file_size(path, error);
+  if (!series->m_data || error ||
+      size < series->m_pointCount * sizeof(chartview::point)) {
+    return tl::make_unexpected(
+        std::format("plot error: archive {} is truncated", path.string()));
+  }
+
+  return series;
+}
+
+tl::expected<void, std::string>
+TiledSeries::Append(std::span<const chartview::point> points) {
+  if (points.empty()) {
+    return {};
+  }
+
+  // One append at a time, each continues where the last one ended
+  std::scoped_lock appending(m_appendMutex);
+  std::optional<double> xLast;
+  {
+    std::scoped_lock lock(m_mutex);
+    if (!m_summaries.empty()) {
+      xLast = m_summaries.back().xLast;
+    }
+  }
+  for (const auto &point : points) {
+    if (xLast && point.x < *xLast) {
+      return tl::make_unexpected(
+          std::format("plot error: archive x {} is below the last x {}",
+                      point.x, *xLast));
+    }
+    xLast = point.x;
+  }
+
+  // Points first, the summaries that make readers look at them after
+  size_t from = 0;
+  {
+    std::scoped_lock lock(m_fileMutex);
+    {
+      std::scoped_lock summaries(m_mutex);
+      from = m_pointCount;
+    }
+    m_data.seekp(static_cast<std::streamoff>(from * sizeof(chartview::point)));
+    m_data.write(reinterpret_cast<const char *>(points.data()),
+                 static_cast<std::streamsize>(points.size_bytes()));
+    if (!m_data.flush()) {
+      m_data.clear();
+      return tl::make_unexpected(std::format(
+          "plot error: cannot write archive {}", m_path.string()));
+    }
+  }
+
+  const size_t firstChunk = from / m_chunkPoints;
+  {
+    std::scoped_lock lock(m_mutex);
+    for (const auto &point : points) {
+      if (m_pointCount % m_chunkPoints == 0) {
+        m_summaries.push_back({.xFirst = point.x,
+                               .xLast = point.x,
+                               .yFirst = point.y,
+                               .yLast = point.y,
+                               .yMin = point.y,
+                               .yMax = point.y,
+                               .sum = point.y,
+                               .count = 1});
+      } else {
+        auto &s = m_summaries.back();
+        s.xLast = point.x;
+        s.yLast = point.y;
+        s.yMin = std::min(s.yMin, point.y);
+        s.yMax = std::max(s.yMax, point.y);
+        s.sum += point.y;
+        ++s.count;
+      }
+      auto &[yMin, yMax] = m_yExtent;
+      yMin = m_pointCount == 0 ? point.y : std::min(yMin, point.y);
+      yMax = m_pointCount == 0 ? point.y : std::max(yMax, point.y);
+      ++m_pointCount;
+    }
+    UpdatePyramid(from);
+  }
+
+  return WriteSummaries(firstChunk);
+}
+
+size_t TiledSeries::GetPointCount() const {
+  std::scoped_lock lock(m_mutex);
+  return m_pointCount;
+}
+
+size_t TiledSeries::GetChunkCount() const {
+  std::scoped_lock lock(m_mutex);
+  return m_summaries.size();
+}
+
+std::optional<std::pair<double, double>> TiledSeries::XRange() const {
+  std::scoped_lock lock(m_mutex);
+  if (m_summaries.empty()) {
+    return std::nullopt;
+  }
+  return std::pair{m_summaries.front().xFirst, m_summaries.back().xLast};
+}
+
+std::optional<std::pair<double, double>> TiledSeries::YRange() const {
+  std::scoped_lock lock(m_mutex);
+  if (m_summaries.empty()) {
+    return std::nullopt;
+  }
+  return m_yExtent;
+}
+
+void TiledSeries::SetCacheBudget(size_t bytes) {
+  std::scoped_lock lock(m_mutex);
+  m_cacheBudget = bytes;
+  Evict();
+}
+
+size_t TiledSeries::GetCacheBudget() const {
+  std::scoped_lock lock(m_mutex);
+  return m_cacheBudget;
+}
+
+size_t TiledSeries::GetCachedBytes() const {
+  std::scoped_lock lock(m_mutex);
+  return m_cachedBytes;
+}
+
+bool TiledSeries::Summarizes(double xLow, double xHigh, int columns) const {
+  std::scoped_lock lock(m_mutex);
+  const auto [first, last] = ChunkRange(xLow, xHigh);
+  return columns > 0 && last - first >= static_cast<size_t>(columns);
+}
+
+std::pmr::vector<chartview::bucket>
+TiledSeries::Columns(double xLow, double xHigh, int columns,
+                     std::pmr::memory_resource *resource) {
+  std::pmr::vector<chartview::bucket> out(resource);
+  if (columns <= 0 || !(xHigh > xLow)) {
+    return out;
+  }
+
+  if (Summarizes(xLow, xHigh, columns)) {
+    return Envelope(xLow, xHigh, columns, resource);
+  }
+  const auto points = Points(xLow, xHigh, resource);
+  return chartview::ReduceColumns(points, xLow, xHigh, columns, resource);
+}
+
+std::pmr::vector<chartview::point>
+TiledSeries::Points(double xLow, double xHigh,
+                    std::pmr::memory_resource *resource) {
+  size_t first = 0;
+  size_t last = 0;
+  size_t count = 0;
+  {
+    std::scoped_lock lock(m_mutex);
+    std::tie(first, last) = ChunkRange(xLow, xHigh);
+    for (size_t c = first; c < last; ++c) {
+      count += m_summaries[c].count;
+    }
+  }
+
+  std::pmr::vector<chartview::point> out(resource);
+  out.reserve(count);
+  for (size_t c = first; c < last; ++c) {
+    if (const auto points = Load(c)) {
+      AppendVisible(*points, xLow, xHigh, out);
+    }
+  }
+  Prefetch(first, last);
+
+  return out;
+}
+
+std::pmr::vector<chartview::bucket>
+TiledSeries::Envelope(double xLow, double xHigh, int columns,
+                      std::pmr::memory_resource *resource) const {
+  // O(columns + log chunks), short enough to hold the lock
+  std::scoped_lock lock(m_mutex);
+  return m_pyramid.Envelope(xLow, xHigh, columns, resource);
+}
+
+std::optional<std::pmr::vector<chartview::point>>
+TiledSeries::CachedPoints(double xLow, double xHigh,
+                          std::pmr::memory_resource *resource) {
+  size_t first = 0;
+  size_t last = 0;
+  size_t count = 0;
+  bool complete = true;
+  std::pmr::vector<chunk> chunks(resource);
+  {
+    std::scoped_lock lock(m_mutex);
+    std::tie(first, last) = ChunkRange(xLow, xHigh);
+    for (size_t c = first; c < last; ++c) {
+      if (!IsCached(c)) {
+        // Visible chunks are queued before the neighbours Prefetch adds
+        Request(c);
+        complete = false;
+        continue;
+      }
+      const auto it = m_cacheIndex.at(c);
+      m_lru.splice(m_lru.begin(), m_lru, it);
+      chunks.push_back(it->points);
+      count += it->points->size();
+    }
+  }
+  Prefetch(first, last);
+  if (!complete) {
+    return std::nullopt;
+  }
+
+  std::pmr::vector<chartview::point> out(resource);
+  out.reserve(count);
+  for (const auto &points : chunks) {
+    AppendVisible(*points, xLow, xHigh, out);
+  }
+  return out;
+}
+
+bool TiledSeries::IsLoading() const {
+  std::scoped_lock lock(m_mutex);
+  return !m_prefetching.empty();
+}
+
+std::pair<size_t, size_t> TiledSeries::ChunkRange(double xLow,
+                                                  double xHigh) const {
+  const auto first = std::ranges::lower_bound(m_summaries, xLow, {},
+                                              &summary::xLast);
+  const auto last = std::ranges::upper_bound(m_summaries, xHigh, {},
+                                             &summary::xFirst);
+  const auto begin = m_summaries.begin();
+  return {static_cast<size_t>(first - begin),
+          static_cast<size_t>(std::max(first, last) - begin)};
+}
+
+TiledSeries::chunk TiledSeries::Load(size_t index) {
+  size_t count = 0;
+  {
+    std::scoped_lock lock(m_mutex);
+    if (index >= m_summaries.size()) {
+      return nullptr;
+    }
+    count = m_summaries[index].count;
+    if (IsCached(index)) {
+      const auto it = m_cacheIndex.at(index);
+      m_lru.splice(m_lru.begin(), m_lru, it);
+      return it->points;
+    }
+  }
+
+  auto points = std::make_shared<std::vector<chartview::point>>(count);
+  {
+    std::scoped_lock lock(m_fileMutex);
+    m_data.seekg(static_cast<std::streamoff>(index * m_chunkPoints *
+                                             sizeof(chartview::point)));
+    m_data.read(reinterpret_cast<char *>(points->data()),
+                static_cast<std::streamsize>(count *
+                                             sizeof(chartview::point)));
+    if (!m_data) {
+      m_data.clear();
+      return nullptr;
+    }
+  }
+
+  std::scoped_lock lock(m_mutex);
+  const auto it = m_cacheIndex.find(index);
+  if (it != m_cacheIndex.end()) {
+    m_cachedBytes -= it->second->points->size() * sizeof(chartview::point);
+    m_lru.erase(it->second);
+  }
+  m_lru.push_front({.index = index, .points = points});
+  m_cacheIndex[index] = m_lru.begin();
+  m_cachedBytes += count * sizeof(chartview::point);
+  Evict();
+
+  return points;
+}
+
+bool TiledSeries::IsCached(size_t index) const {
+  const auto it = m_cacheIndex.find(index);
+  return it != m_cacheIndex.end() &&
+         it->second->points->size() == m_summaries[index].count;
+}
+
+void TiledSeries::Prefetch(size_t first, size_t last) {
+  std::scoped_lock lock(m_mutex);
+  // One view width on each side, within what the budget holds beside the
+  // visible chunks
+  const size_t chunkBytes = m_chunkPoints * sizeof(chartview::point);
+  const size_t room = m_cacheBudget / chunkBytes;
+  const size_t visible = last - first;
+  const size_t side =
+      room > visible ? std::min(std::max<size_t>(visible, 1),
+                                (room - visible) / 2)
+                     : 0;
+
+  for (size_t i = 1; i <= side; ++i) {
+    Request(last - 1 + i);
+    if (first >= i) {
+      Request(first - i);
+    }
+  }
+}
+
+void TiledSeries::Request(size_t index) {
+  if (index >= m_summaries.size() || IsCached(index) ||
+      !m_prefetching.insert(index).second) {
+    return;
+  }
+  static_cast<void>(m_prefetchPool.Submit([this, index]() {
+    static_cast<void>(Load(index));
+    std::scoped_lock done(m_mutex);
+    m_prefetching.erase(index);
+  }));
+}
+
+void TiledSeries::AppendVisible(const std::vector<chartview::point> &points,
+                                double xLow, double xHigh,
+                                std::pmr::vector<chartview::point> &out) {
+  // x is sorted, only the first and last chunk need trimming
+  const auto begin =
+      std::ranges::lower_bound(points, xLow, {}, &chartview::point::x);
+  const auto end =
+      std::ranges::upper_bound(points, xHigh, {}, &chartview::point::x);
+  out.insert(out.end(), begin, std::max(begin, end));
+}
+
+void TiledSeries::Evict() {
+  while (m_cachedBytes > m_cacheBudget && m_lru.size() > 1) {
+    const auto &oldest = m_lru.back();
+    m_cachedBytes -= oldest.points->size() * sizeof(chartview::point);
+    m_cacheIndex.erase(oldest.index);
+    m_lru.pop_back();
+  }
+}
+
+void TiledSeries::UpdatePyramid(size_t from) {
+  for (size_t c = from / m_chunkPoints; c < m_pointCount / m_chunkPoints;
+       ++c) {
+    m_pyramid.AppendNode(m_summaries[c]);
+  }
+  m_pyramid.SetPartial(m_pointCount % m_chunkPoints != 0 ? m_summaries.back()
+                                                         : summary{});
+}
+
+tl::expected<void, std::string> TiledSeries::WriteSummaries(size_t first) {
+  std::vector<summary> changed;
+  {
+    std::scoped_lock lock(m_mutex);
+    changed.assign(m_summaries.begin() + static_cast<std::ptrdiff_t>(first),
+                   m_summaries.end());
+  }
+
+  std::scoped_lock lock(m_fileMutex);
+  m_index.seekp(static_cast<std::streamoff>(sizeof(indexheader) +
+                                            (first * sizeof(summary))));
+  m_index.write(reinterpret_cast<const char *>(changed.data()),
+                static_cast<std::streamsize>(changed.size() * sizeof(summary)));
+  if (!m_index.flush()) {
+    m_index.clear();
+    return tl::make_unexpected(std::format(
+        "plot error: cannot write archive index {}",
+        IndexPath(m_path).string()));
+  }
+  return {};
+}
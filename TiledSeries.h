@@ -0,0 +1,172 @@
+#pragma once
+
+#include "LodPyramid.h"
+#include "ThreadPool.h"
+#include "expected.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace chartview {
+struct point;
+struct bucket;
+} // namespace chartview
+
+// Out-of-core series for archives far larger than memory. Points are
+// stored on disk in fixed size chunks, next to an index file holding a
+// summary (x range, first, last, lowest and highest y, sum, count) per
+// chunk. Only the summaries are held in memory, chunks are read on demand
+// into an LRU cache bounded by a memory budget.
+//
+// Views covering at least one chunk per column are drawn from a level of
+// detail pyramid built over the summaries, in O(columns + log chunks).
+// Closer views read the visible chunks and prefetch their neighbours on a
+// background thread, so panning finds them cached. Threads that must not
+// wait for the disk use Envelope and CachedPoints, which leave reading to
+// that thread.
+//
+// All members are safe to call from any thread, appends may run while
+// other threads draw.
+class TiledSeries {
+public:
+  static constexpr size_t defaultChunkPoints = 8192;
+  static constexpr size_t defaultCacheBudget = size_t{256} << 20;
+
+  // Create an empty archive at path, replacing any file there. The index
+  // is written next to it with ".idx" appended to the name.
+  static tl::expected<std::unique_ptr<TiledSeries>, std::string>
+  Create(const std::filesystem::path &path,
+         size_t chunkPoints = defaultChunkPoints);
+  // Open an archive written before, reads the index only
+  static tl::expected<std::unique_ptr<TiledSeries>, std::string>
+  Open(const std::filesystem::path &path);
+
+  ~TiledSeries();
+
+  TiledSeries(const TiledSeries &) = delete;
+  TiledSeries &operator=(const TiledSeries &) = delete;
+  TiledSeries(TiledSeries &&) = delete;
+  TiledSeries &operator=(TiledSeries &&) = delete;
+
+  // Append points at the end, x must not decrease
+  tl::expected<void, std::string>
+  Append(std::span<const chartview::point> points);
+
+  [[nodiscard]] size_t GetPointCount() const;
+  [[nodiscard]] size_t GetChunkCount() const;
+  [[nodiscard]] std::optional<std::pair<double, double>> XRange() const;
+  [[nodiscard]] std::optional<std::pair<double, double>> YRange() const;
+
+  // Bytes of decoded chunks kept in memory, the least recently used are
+  // dropped first. Chunks in use by a frame stay alive until it is done.
+  void SetCacheBudget(size_t bytes);
+  [[nodiscard]] size_t GetCacheBudget() const;
+  [[nodiscard]] size_t GetCachedBytes() const;
+
+  // Whether [xLow, xHigh] over columns is drawn from the summaries, i.e.
+  // it spans at least one chunk per column
+  [[nodiscard]] bool Summarizes(double xLow, double xHigh, int columns) const;
+  // Per column reduction of the points with x in [xLow, xHigh] as
+  // ReduceColumns computes it, from the summaries when Summarizes and from
+  // the points otherwise. Summarized chunks are assigned to columns whole.
+  [[nodiscard]] std::pmr::vector<chartview::bucket>
+  Columns(double xLow, double xHigh, int columns,
+          std::pmr::memory_resource *resource =
+              std::pmr::get_default_resource());
+  // The points with x in [xLow, xHigh], read through the cache. Reads
+  // every visible chunk, meant for views Summarizes turns down.
+  [[nodiscard]] std::pmr::vector<chartview::point>
+  Points(double xLow, double xHigh,
+         std::pmr::memory_resource *resource =
+             std::pmr::get_default_resource());
+
+  // Columns from the summaries alone, also for views Summarizes turns
+  // down, which then get whole chunks per column. Never reads chunks.
+  [[nodiscard]] std::pmr::vector<chartview::bucket>
+  Envelope(double xLow, double xHigh, int columns,
+           std::pmr::memory_resource *resource =
+               std::pmr::get_default_resource()) const;
+  // Points if every visible chunk is cached. Otherwise nothing, and the
+  // missing chunks are queued for the background thread instead of read.
+  [[nodiscard]] std::optional<std::pmr::vector<chartview::point>>
+  CachedPoints(double xLow, double xHigh,
+               std::pmr::memory_resource *resource =
+                   std::pmr::get_default_resource());
+  // Whether chunks are being read on the background thread
+  [[nodiscard]] bool IsLoading() const;
+
+private:
+  // Also the layout of the summaries in the index file
+  using summary = LodPyramid::node;
+  using chunk = std::shared_ptr<const std::vector<chartview::point>>;
+  struct cached {
+    size_t index;
+    chunk points;
+  };
+
+  TiledSeries(std::filesystem::path path, size_t chunkPoints);
+
+  // Chunks [first, last) overlapping [xLow, xHigh], m_mutex held
+  [[nodiscard]] std::pair<size_t, size_t> ChunkRange(double xLow,
+                                                     double xHigh) const;
+  // The points of chunk index from the cache or the disk, nullptr if they
+  // cannot be read
+  chunk Load(size_t index);
+  // Whether chunk index is cached as it is now, a last chunk may have
+  // grown since it was read. m_mutex held.
+  [[nodiscard]] bool IsCached(size_t index) const;
+  // Read the chunks beside [first, last) in the background, as many as
+  // the cache budget leaves room for
+  void Prefetch(size_t first, size_t last);
+  // Read chunk index in the background unless cached or queued, m_mutex
+  // held
+  void Request(size_t index);
+  // Append the points of a chunk with x in [xLow, xHigh] to out
+  static void AppendVisible(const std::vector<chartview::point> &points,
+                            double xLow, double xHigh,
+                            std::pmr::vector<chartview::point> &out);
+  // Drop least recently used chunks until the budget is met, m_mutex held
+  void Evict();
+  // Add the chunks completed since point from to the pyramid and make the
+  // last one its partial node, m_mutex held
+  void UpdatePyramid(size_t from);
+  tl::expected<void, std::string> WriteSummaries(size_t first);
+
+  const std::filesystem::path m_path;
+  const size_t m_chunkPoints;
+
+  // Guards the summaries and the cache
+  mutable std::mutex m_mutex;
+  std::vector<summary> m_summaries;
+  // Over m_summaries, complete chunks as level 0 nodes
+  LodPyramid m_pyramid;
+  size_t m_pointCount = 0;
+  std::pair<double, double> m_yExtent{0, 0};
+  std::list<cached> m_lru;
+  std::unordered_map<size_t, std::list<cached>::iterator> m_cacheIndex;
+  std::unordered_set<size_t> m_prefetching;
+  size_t m_cacheBudget = defaultCacheBudget;
+  size_t m_cachedBytes = 0;
+
+  // Serializes appends
+  std::mutex m_appendMutex;
+  // Guards both file streams, which appends and chunk reads share
+  std::mutex m_fileMutex;
+  std::fstream m_data;
+  std::fstream m_index;
+
+  // Last, so pending prefetches finish before the rest is destroyed
+  ThreadPool m_prefetchPool{1};
+};
@@ -0,0 +1,220 @@
+#include "ChartViewTests.h"
+#include "TiledSeries.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+// Points with x in [xLow, xHigh], found by a scan
+std::vector<chartview::point>
+BruteVisible(std::span<const chartview::point> points, double xLow,
+             double xHigh) {
+  std::vector<chartview::point> out;
+  std::ranges::copy_if(points, std::back_inserter(out),
+                       [&](const chartview::point &p) {
+                         return p.x >= xLow && p.x <= xHigh;
+                       });
+  return out;
+}
+
+bool SamePoints(std::span<const chartview::point> a,
+                std::span<const chartview::point> b) {
+  return std::ranges::equal(
+      a, b, [](const chartview::point &p, const chartview::point &q) {
+        return p.x == q.x && p.y == q.y;
+      });
+}
+
+// Counts and extents of the archive against the points appended to it
+void CheckExtents(const TiledSeries &archive,
+                  std::span<const chartview::point> points,
+                  size_t chunkPoints, std::string_view what) {
+  const auto xRange = archive.XRange();
+  const auto yRange = archive.YRange();
+  const bool empty = points.empty();
+  if (archive.GetPointCount() != points.size() ||
+      archive.GetChunkCount() !=
+          (points.size() + chunkPoints - 1) / chunkPoints ||
+      xRange.has_value() == empty || yRange.has_value() == empty ||
+      (!empty && (*xRange != std::pair(points.front().x, points.back().x) ||
+                  *yRange != BruteExtent(points, 0, points.size())))) {
+    Fail(std::format("{}: {} points in {} chunks, {} appended", what,
+                     archive.GetPointCount(), archive.GetChunkCount(),
+                     points.size()));
+  }
+}
+
+// Random views read through the archive compared with a scan of the
+// points: the points themselves, read or cached, the columns of close
+// views and envelopes holding every visible point
+void CheckViews(TiledSeries &archive, std::span<const chartview::point> points,
+                std::mt19937 &rng, std::string_view what) {
+  if (points.empty()) {
+    return;
+  }
+  const double low = points.front().x;
+  const double high = points.back().x;
+  std::uniform_real_distribution<double> within(low - 1, high + 1);
+  for (int view = 0; view < 20; ++view) {
+    // Some views end on points, repeated x among them
+    auto end = [&]() {
+      return view % 2 == 0 ? points[rng() % points.size()].x : within(rng);
+    };
+    double xLow = end();
+    double xHigh = end();
+    if (xHigh < xLow) {
+      std::swap(xLow, xHigh);
+    }
+    const int columns = 1 + static_cast<int>(rng() % 100);
+    const auto visible = BruteVisible(points, xLow, xHigh);
+    const auto where = std::format("{} view [{}, {}] over {} columns", what,
+                                   xLow, xHigh, columns);
+
+    if (!SamePoints(archive.Points(xLow, xHigh), visible)) {
+      Fail(std::format("{}: points differ from a scan", where));
+    }
+    std::optional<std::pmr::vector<chartview::point>> cached;
+    for (int attempt = 0; attempt < 5000; ++attempt) {
+      if ((cached = archive.CachedPoints(xLow, xHigh))) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (!cached || !SamePoints(*cached, visible)) {
+      Fail(std::format("{}: cached points differ from a scan", where));
+    }
+
+    if (!(xHigh > xLow)) {
+      continue;
+    }
+    if (!archive.Summarizes(xLow, xHigh, columns) &&
+        !SameColumns(archive.Columns(xLow, xHigh, columns),
+                     chartview::ReduceColumns(visible, xLow, xHigh,
+                                              columns))) {
+      Fail(std::format("{}: columns differ from ReduceColumns", where));
+    }
+
+    // Whole nodes go to columns, the envelope may reach past the view
+    const auto envelope = archive.Envelope(xLow, xHigh, columns);
+    const auto [yMin, yMax] = BruteExtent(visible, 0, visible.size());
+    double envelopeMin = yMax;
+    double envelopeMax = yMin;
+    for (size_t i = 0; i < envelope.size(); ++i) {
+      const auto &b = envelope[i];
+      envelopeMin = std::min(envelopeMin, b.min);
+      envelopeMax = std::max(envelopeMax, b.max);
+      if (b.column < 0 || b.column >= columns ||
+          (i > 0 && b.column <= envelope[i - 1].column) || b.min > b.max ||
+          b.first < b.min || b.first > b.max || b.last < b.min ||
+          b.last > b.max) {
+        Fail(std::format("{}: envelope column {} out of place", where,
+                         b.column));
+      }
+    }
+    if (!visible.empty() && (envelopeMin > yMin || envelopeMax < yMax)) {
+      Fail(std::format("{}: envelope [{}, {}] misses points in [{}, {}]",
+                       where, envelopeMin, envelopeMax, yMin, yMax));
+    }
+  }
+
+  // One column over everything is the whole series
+  const auto whole = archive.Envelope(low, high + 1, 1);
+  const auto [yMin, yMax] = BruteExtent(points, 0, points.size());
+  if (whole.size() != 1 || whole[0].first != points.front().y ||
+      whole[0].last != points.back().y || whole[0].min != yMin ||
+      whole[0].max != yMax) {
+    Fail(std::format("{}: envelope of the whole series", what));
+  }
+}
+} // namespace
+
+// An archive grown by appends of random sizes over chunks of random
+// length, then opened again and grown further, compared with the points
+// appended to it
+void TestTiledSeries(std::mt19937 &rng) {
+  const auto directory = std::filesystem::temp_directory_path() /
+                         ("ChartViewTests-" + std::to_string(rng()));
+  std::filesystem::create_directories(directory);
+  const auto path = directory / "archive";
+  const size_t chunkPoints = 1 + (rng() % 200);
+  std::vector<chartview::point> points;
+  double x = 0;
+  auto append = [&](TiledSeries &archive, int rounds, std::string_view what) {
+    for (int round = 0; round < rounds; ++round) {
+      std::vector<chartview::point> added(rng() % 500);
+      for (auto &p : added) {
+        // Repeated x included
+        x += static_cast<double>(rng() % 3) / 8;
+        p = {.x = x, .y = RandomY(rng)};
+      }
+      if (auto res = archive.Append(added); !res) {
+        Fail(std::format("{} round {}: {}", what, round, res.error()));
+        return;
+      }
+      points.insert(points.end(), added.begin(), added.end());
+      const auto where = std::format("{} round {}", what, round);
+      CheckExtents(archive, points, chunkPoints, where);
+      if (round % 10 == 9) {
+        CheckViews(archive, points, rng, where);
+      }
+    }
+  };
+
+  {
+    auto created = TiledSeries::Create(path, chunkPoints);
+    if (!created) {
+      Fail(std::format("TiledSeries: {}", created.error()));
+      return;
+    }
+    auto &archive = **created;
+    CheckExtents(archive, points, chunkPoints, "TiledSeries created");
+    append(archive, 60, "TiledSeries");
+
+    const std::vector<chartview::point> back{{.x = x - 1, .y = 0}};
+    if (archive.Append(back)) {
+      Fail("TiledSeries: appended a decreasing x");
+    }
+    CheckExtents(archive, points, chunkPoints, "TiledSeries rejected");
+
+    // Unused chunks are dropped down to the budget, one is always kept
+    const size_t budget = 4 * chunkPoints * sizeof(chartview::point);
+    archive.SetCacheBudget(budget);
+    static_cast<void>(archive.Points(-1, x + 1));
+    while (archive.IsLoading()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (archive.GetCacheBudget() != budget ||
+        archive.GetCachedBytes() > budget) {
+      Fail(std::format("TiledSeries: {} bytes cached for a budget of {}",
+                       archive.GetCachedBytes(), budget));
+    }
+  }
+
+  {
+    auto opened = TiledSeries::Open(path);
+    if (!opened) {
+      Fail(std::format("TiledSeries: {}", opened.error()));
+      return;
+    }
+    auto &archive = **opened;
+    CheckExtents(archive, points, chunkPoints, "TiledSeries opened");
+    CheckViews(archive, points, rng, "TiledSeries opened");
+    append(archive, 20, "TiledSeries opened");
+  }
+
+  if (TiledSeries::Open(directory / "missing") ||
+      TiledSeries::Create(path, 0)) {
+    Fail("TiledSeries: opened a missing archive or created empty chunks");
+  }
+  std::filesystem::remove_all(directory);
+}
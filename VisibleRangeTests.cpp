@@ -0,0 +1,80 @@
+#include "ChartViewTests.h"
+#include <algorithm>
+#include <format>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace {
+// Points [first, last) with x in [xLow, xHigh] of sorted points, found by
+// a scan
+std::pair<size_t, size_t> BruteRange(std::span<const chartview::point> points,
+                                     double xLow, double xHigh) {
+  const auto first = static_cast<size_t>(std::ranges::count_if(
+      points, [xLow](const chartview::point &p) { return p.x < xLow; }));
+  const auto last = static_cast<size_t>(std::ranges::count_if(
+      points, [xHigh](const chartview::point &p) { return p.x <= xHigh; }));
+  return {first, std::max(first, last)};
+}
+} // namespace
+
+// Visible slices of uniform, sorted and unsorted x, also while a window
+// evicts the oldest points, compared with a scan
+void TestVisibleRange(std::mt19937 &rng) {
+  for (int round = 0; round < 200; ++round) {
+    const int layout = round % 3;
+    const std::string_view name =
+        layout == 0 ? "uniform" : (layout == 1 ? "sorted" : "unsorted");
+    ChartRenderer renderer;
+    if (round % 2 == 0) {
+      static_cast<void>(renderer.SetTimeWindow(50.0));
+    }
+
+    // Steps of a tenth are not exact, the index arithmetic must correct
+    // its guess; sorted x repeats some values
+    double x = std::uniform_real_distribution<double>(-100, 100)(rng);
+    for (int block = 0; block < 5; ++block) {
+      std::vector<double> xs(rng() % 300);
+      std::vector<double> ys(xs.size());
+      for (size_t i = 0; i < xs.size(); ++i) {
+        if (layout == 0) {
+          x += 0.1;
+        } else if (layout == 1) {
+          x += static_cast<double>(rng() % 4) / 8;
+        } else {
+          x = std::uniform_real_distribution<double>(-100, 100)(rng);
+        }
+        xs[i] = x;
+        ys[i] = RandomY(rng);
+      }
+      static_cast<void>(block == 0 ? renderer.SetPlotData(xs, ys)
+                                   : renderer.AppendPlotData(xs, ys));
+
+      const auto data = renderer.GetSeries();
+      const std::span<const chartview::point> points = data->points;
+      const double low = points.empty() ? 0 : data->xMinmax.first;
+      const double high = points.empty() ? 1 : data->xMinmax.second;
+      if (layout == 0 && points.size() > 2 && !(data->xStep > 0)) {
+        Fail(std::format("VisibleRange round {}: x spaced by a tenth is not "
+                         "taken as uniform",
+                         round));
+      }
+      std::uniform_real_distribution<double> within(low - 5, high + 5);
+      for (int view = 0; view < 20; ++view) {
+        const double xLow = within(rng);
+        const double xHigh = view % 5 == 0 ? xLow : within(rng);
+        const auto range = renderer.VisibleRange(xLow, xHigh);
+        const auto expected = data->xSorted
+                                  ? BruteRange(points, xLow, xHigh)
+                                  : std::pair<size_t, size_t>{0, points.size()};
+        if (range != expected) {
+          Fail(std::format("VisibleRange {} round {}: [{}, {}) of {} points "
+                           "for [{}, {}], expected [{}, {})",
+                           name, round, range.first, range.second,
+                           points.size(), xLow, xHigh, expected.first,
+                           expected.second));
+        }
+      }
+    }
+  }
+}